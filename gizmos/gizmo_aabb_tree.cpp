@@ -0,0 +1,318 @@
+#include "gizmo_aabb_tree.h"
+
+static _FORCE_INLINE_ real_t _surface_area(const AABB& p_aabb) {
+	const Vector3& s = p_aabb.size;
+	return 2.0 * (s.x * s.y + s.y * s.z + s.z * s.x);
+}
+
+static _FORCE_INLINE_ real_t _far_distance(const AABB& p_aabb, const Vector3& p_from) {
+	Vector3 from = p_from - p_aabb.position;
+	Vector3 to = p_from - (p_aabb.position + p_aabb.size);
+	return Vector3(MAX(ABS(from.x), ABS(to.x)), MAX(ABS(from.y), ABS(to.y)), MAX(ABS(from.z), ABS(to.z))).length();
+}
+
+int GizmoAABBTree::_alloc_node() {
+	if (free_list != -1) {
+		int node = free_list;
+		free_list = nodes[node].parent;
+		nodes.write[node] = Node();
+		return node;
+	}
+
+	nodes.push_back(Node());
+	return nodes.size() - 1;
+}
+
+void GizmoAABBTree::_free_node(int p_node) {
+	nodes.write[p_node].parent = free_list;
+	nodes.write[p_node].height = -1;
+	free_list = p_node;
+}
+
+void GizmoAABBTree::_refit_node(int p_node) {
+	Node* n = nodes.ptrw();
+	const Node& left = n[n[p_node].left];
+	const Node& right = n[n[p_node].right];
+	n[p_node].aabb = left.aabb.merge(right.aabb);
+	n[p_node].icon_size = MAX(left.icon_size, right.icon_size);
+	n[p_node].height = 1 + MAX(left.height, right.height);
+}
+
+void GizmoAABBTree::_fix_upwards(int p_node) {
+	int node = p_node;
+	while (node != -1) {
+		node = _balance(node);
+		_refit_node(node);
+		node = nodes[node].parent;
+	}
+}
+
+int GizmoAABBTree::_balance(int p_node) {
+	const Node* n = nodes.ptr();
+	if (n[p_node].is_leaf() || n[p_node].height < 2) {
+		return p_node;
+	}
+
+	int left = n[p_node].left;
+	int right = n[p_node].right;
+	int balance = n[right].height - n[left].height;
+	if (balance > 1) {
+		return _rotate_up(p_node, right);
+	}
+	if (balance < -1) {
+		return _rotate_up(p_node, left);
+	}
+	return p_node;
+}
+
+int GizmoAABBTree::_rotate_up(int p_node, int p_child) {
+	Node* n = nodes.ptrw();
+
+	// The taller grandchild stays under the child, the other one takes the child's place under the node.
+	int keep = n[p_child].left;
+	int move = n[p_child].right;
+	if (n[keep].height < n[move].height) {
+		SWAP(keep, move);
+	}
+
+	int parent = n[p_node].parent;
+	n[p_child].parent = parent;
+	if (parent == -1) {
+		root = p_child;
+	}
+	else if (n[parent].left == p_node) {
+		n[parent].left = p_child;
+	}
+	else {
+		n[parent].right = p_child;
+	}
+
+	if (n[p_node].left == p_child) {
+		n[p_node].left = move;
+	}
+	else {
+		n[p_node].right = move;
+	}
+	n[move].parent = p_node;
+
+	n[p_child].left = p_node;
+	n[p_child].right = keep;
+	n[p_node].parent = p_child;
+
+	_refit_node(p_node);
+	_refit_node(p_child);
+	return p_child;
+}
+
+void GizmoAABBTree::_insert_leaf(int p_leaf) {
+	if (root == -1) {
+		root = p_leaf;
+		nodes.write[p_leaf].parent = -1;
+		return;
+	}
+
+	// Walk down to the sibling that makes the tree's total surface area grow the least.
+	AABB leaf_aabb = nodes[p_leaf].aabb;
+	int sibling = root;
+	while (!nodes[sibling].is_leaf()) {
+		const Node& node = nodes[sibling];
+		real_t area = _surface_area(node.aabb);
+		real_t combined_area = _surface_area(node.aabb.merge(leaf_aabb));
+
+		// Cost of pairing the leaf with this node, and the growth every node below has to pay on top.
+		real_t cost = 2.0 * combined_area;
+		real_t inheritance = 2.0 * (combined_area - area);
+
+		real_t child_cost[2];
+		int children[2] = { node.left, node.right };
+		for (int i = 0; i < 2; i++) {
+			const Node& child = nodes[children[i]];
+			child_cost[i] = _surface_area(child.aabb.merge(leaf_aabb)) + inheritance;
+			if (!child.is_leaf()) {
+				child_cost[i] -= _surface_area(child.aabb);
+			}
+		}
+
+		if (cost < child_cost[0] && cost < child_cost[1]) {
+			break;
+		}
+		sibling = child_cost[0] < child_cost[1] ? children[0] : children[1];
+	}
+
+	int old_parent = nodes[sibling].parent;
+	int new_parent = _alloc_node();
+	Node* n = nodes.ptrw();
+	n[new_parent].parent = old_parent;
+	n[new_parent].left = sibling;
+	n[new_parent].right = p_leaf;
+	n[sibling].parent = new_parent;
+	n[p_leaf].parent = new_parent;
+
+	if (old_parent == -1) {
+		root = new_parent;
+	}
+	else if (n[old_parent].left == sibling) {
+		n[old_parent].left = new_parent;
+	}
+	else {
+		n[old_parent].right = new_parent;
+	}
+
+	_fix_upwards(new_parent);
+}
+
+void GizmoAABBTree::_remove_leaf(int p_leaf) {
+	if (p_leaf == root) {
+		root = -1;
+		return;
+	}
+
+	Node* n = nodes.ptrw();
+	int parent = n[p_leaf].parent;
+	int grand_parent = n[parent].parent;
+	int sibling = n[parent].left == p_leaf ? n[parent].right : n[parent].left;
+
+	// The sibling takes the parent's place, the parent goes away.
+	n[sibling].parent = grand_parent;
+	if (grand_parent == -1) {
+		root = sibling;
+	}
+	else if (n[grand_parent].left == parent) {
+		n[grand_parent].left = sibling;
+	}
+	else {
+		n[grand_parent].right = sibling;
+	}
+	_free_node(parent);
+
+	if (grand_parent != -1) {
+		_fix_upwards(grand_parent);
+	}
+}
+
+int GizmoAABBTree::insert(const AABB& p_aabb, float p_icon_size, ObjectID p_id) {
+	int leaf = _alloc_node();
+	Node& node = nodes.write[leaf];
+	node.aabb = p_aabb;
+	node.icon_size = p_icon_size;
+	node.id = p_id;
+	_insert_leaf(leaf);
+	return leaf;
+}
+
+void GizmoAABBTree::update(int p_leaf, const AABB& p_aabb, float p_icon_size) {
+	ERR_FAIL_INDEX(p_leaf, nodes.size());
+	ERR_FAIL_COND(!nodes[p_leaf].is_leaf() || nodes[p_leaf].height != 0);
+
+	if (nodes[p_leaf].aabb == p_aabb && nodes[p_leaf].icon_size == p_icon_size) {
+		return;
+	}
+
+	_remove_leaf(p_leaf);
+	nodes.write[p_leaf].aabb = p_aabb;
+	nodes.write[p_leaf].icon_size = p_icon_size;
+	_insert_leaf(p_leaf);
+}
+
+void GizmoAABBTree::remove(int p_leaf) {
+	ERR_FAIL_INDEX(p_leaf, nodes.size());
+	ERR_FAIL_COND(!nodes[p_leaf].is_leaf() || nodes[p_leaf].height != 0);
+
+	_remove_leaf(p_leaf);
+	_free_node(p_leaf);
+}
+
+void GizmoAABBTree::clear() {
+	nodes.clear();
+	root = -1;
+	free_list = -1;
+}
+
+void GizmoAABBTree::query_ray(const Vector3& p_from, const Vector3& p_dir, float p_margin, float p_fixed_scale, Vector<ObjectID>& r_ids) const {
+	if (root == -1) {
+		return;
+	}
+
+	const Node* n = nodes.ptr();
+
+	// Every node pushes its two children after being popped, so the stack never holds more than
+	// the height of the tree plus one, and the balancing keeps that well under this.
+	int stack[64];
+	int top = 0;
+	stack[top++] = root;
+
+	while (top > 0) {
+		const Node& node = n[stack[--top]];
+		real_t scale = p_fixed_scale > 0 ? p_fixed_scale : _far_distance(node.aabb, p_from);
+		AABB grown = node.aabb.grow((p_margin + node.icon_size) * scale);
+		if (!grown.intersects_ray(p_from, p_dir)) {
+			continue;
+		}
+
+		if (node.is_leaf()) {
+			r_ids.push_back(node.id);
+		}
+		else {
+			ERR_FAIL_COND(top + 2 > 64);
+			stack[top++] = node.left;
+			stack[top++] = node.right;
+		}
+	}
+}
+
+void GizmoAABBTree::query_frustum(const Vector<Plane>& p_frustum, Vector<ObjectID>& r_ids) const {
+	if (root == -1) {
+		return;
+	}
+
+	struct StackItem {
+		int node;
+		bool inside;
+	};
+
+	const Node* n = nodes.ptr();
+	const Plane* planes = p_frustum.ptr();
+	int plane_count = p_frustum.size();
+
+	StackItem stack[64];
+	int top = 0;
+	stack[top++] = { root, false };
+
+	while (top > 0) {
+		StackItem item = stack[--top];
+		const Node& node = n[item.node];
+
+		if (!item.inside) {
+			// Per plane, the corner furthest along the normal decides if any of the box is inside,
+			// the nearest corner if all of it is.
+			bool outside = false;
+			bool inside = true;
+			Vector3 begin = node.aabb.position;
+			Vector3 end = node.aabb.position + node.aabb.size;
+			for (int i = 0; i < plane_count && !outside; i++) {
+				const Vector3& normal = planes[i].normal;
+				Vector3 near_corner(normal.x > 0 ? begin.x : end.x, normal.y > 0 ? begin.y : end.y, normal.z > 0 ? begin.z : end.z);
+				Vector3 far_corner(normal.x > 0 ? end.x : begin.x, normal.y > 0 ? end.y : begin.y, normal.z > 0 ? end.z : begin.z);
+				if (planes[i].is_point_over(near_corner)) {
+					outside = true;
+				}
+				else if (planes[i].is_point_over(far_corner)) {
+					inside = false;
+				}
+			}
+			if (outside) {
+				continue;
+			}
+			item.inside = inside;
+		}
+
+		if (node.is_leaf()) {
+			r_ids.push_back(node.id);
+		}
+		else {
+			ERR_FAIL_COND(top + 2 > 64);
+			stack[top++] = { node.left, item.inside };
+			stack[top++] = { node.right, item.inside };
+		}
+	}
+}
@@ -0,0 +1,58 @@
+#ifndef GIZMO_AABB_TREE_H
+#define GIZMO_AABB_TREE_H
+
+#include "core/math/aabb.h"
+#include "core/math/plane.h"
+#include "core/object.h"
+#include "core/vector.h"
+
+// Dynamic bounding volume tree over the pickable parts of gizmos, so picking only looks at the
+// gizmos whose boxes the mouse ray passes near. Leaves go next to the sibling whose box grows
+// the least, and nodes are rotated as in an AVL tree to keep the depth logarithmic.
+class GizmoAABBTree {
+	struct Node {
+		AABB aabb;
+		// Largest icon size of the subtree. Icons are drawn at a fixed size on screen, so they
+		// cover more of the world the further they are from the camera.
+		float icon_size = 0;
+		ObjectID id = 0;
+		int parent = -1; // Next free node while the node is on the free list.
+		int left = -1;
+		int right = -1;
+		int height = 0;
+
+		bool is_leaf() const { return left == -1; }
+	};
+
+	Vector<Node> nodes;
+	int root = -1;
+	int free_list = -1;
+
+	int _alloc_node();
+	void _free_node(int p_node);
+	void _refit_node(int p_node);
+	void _fix_upwards(int p_node);
+	int _balance(int p_node);
+	int _rotate_up(int p_node, int p_child);
+	void _insert_leaf(int p_leaf);
+	void _remove_leaf(int p_leaf);
+
+public:
+	int insert(const AABB& p_aabb, float p_icon_size, ObjectID p_id);
+	// Moved leaves are taken out and inserted again, which refits their old and new paths.
+	void update(int p_leaf, const AABB& p_aabb, float p_icon_size);
+	void remove(int p_leaf);
+	void clear();
+
+	// Appends the ids of the leaves the ray passes within (p_margin + icon size) * scale of, in no particular
+	// order. Scale is the distance from p_from to the far corner of the box, or p_fixed_scale when it is
+	// positive, for orthogonal cameras where the size on screen doesn't depend on the distance.
+	void query_ray(const Vector3& p_from, const Vector3& p_dir, float p_margin, float p_fixed_scale, Vector<ObjectID>& r_ids) const;
+	// Appends the ids of the leaves whose box is not entirely on the outer side of one of the planes.
+	// Subtrees found entirely inside are collected without testing their boxes again.
+	void query_frustum(const Vector<Plane>& p_frustum, Vector<ObjectID>& r_ids) const;
+
+	bool empty() const { return root == -1; }
+};
+
+#endif
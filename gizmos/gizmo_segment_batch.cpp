@@ -0,0 +1,143 @@
+#include "gizmo_segment_batch.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define GIZMO_SEGMENT_BATCH_SSE2
+#include <emmintrin.h>
+#endif
+
+// Segments shorter than this on screen are treated as their first point, like Geometry does.
+static const float SEGMENT_MIN_LENGTH_SQUARED = 1e-20;
+
+void gizmo_xform_points(const Transform& p_xform, const Vector3* p_points, int p_stride, int p_count, float* r_x, float* r_y, float* r_z) {
+	const Basis& b = p_xform.basis;
+	const Vector3& o = p_xform.origin;
+	for (int i = 0; i < p_count; i++) {
+		const Vector3& v = p_points[i * p_stride];
+		r_x[i] = b.elements[0][0] * v.x + b.elements[0][1] * v.y + b.elements[0][2] * v.z + o.x;
+		r_y[i] = b.elements[1][0] * v.x + b.elements[1][1] * v.y + b.elements[1][2] * v.z + o.y;
+		r_z[i] = b.elements[2][0] * v.x + b.elements[2][1] * v.y + b.elements[2][2] * v.z + o.z;
+	}
+}
+
+static bool _any_over_plane_scalar(const float* p_x, const float* p_y, const float* p_z, int p_count, const Plane& p_plane) {
+	float nx = p_plane.normal.x;
+	float ny = p_plane.normal.y;
+	float nz = p_plane.normal.z;
+	float d = p_plane.d;
+	for (int i = 0; i < p_count; i++) {
+		if (nx * p_x[i] + ny * p_y[i] + nz * p_z[i] > d) {
+			return true;
+		}
+	}
+	return false;
+}
+
+#ifdef GIZMO_SEGMENT_BATCH_SSE2
+static bool _any_over_plane_sse2(const float* p_x, const float* p_y, const float* p_z, int p_count, const Plane& p_plane) {
+	__m128 nx = _mm_set1_ps(p_plane.normal.x);
+	__m128 ny = _mm_set1_ps(p_plane.normal.y);
+	__m128 nz = _mm_set1_ps(p_plane.normal.z);
+	__m128 d = _mm_set1_ps(p_plane.d);
+
+	int i = 0;
+	for (; i + 4 <= p_count; i += 4) {
+		__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, _mm_loadu_ps(p_x + i)), _mm_mul_ps(ny, _mm_loadu_ps(p_y + i))), _mm_mul_ps(nz, _mm_loadu_ps(p_z + i)));
+		if (_mm_movemask_ps(_mm_cmpgt_ps(dot, d))) {
+			return true;
+		}
+	}
+
+	return _any_over_plane_scalar(p_x + i, p_y + i, p_z + i, p_count - i, p_plane);
+}
+#endif
+
+bool gizmo_points_inside_planes(const float* p_x, const float* p_y, const float* p_z, int p_count, const Plane* p_planes, int p_plane_count) {
+	for (int j = 0; j < p_plane_count; j++) {
+#ifdef GIZMO_SEGMENT_BATCH_SSE2
+		bool any_over = _any_over_plane_sse2(p_x, p_y, p_z, p_count, p_planes[j]);
+#else
+		bool any_over = _any_over_plane_scalar(p_x, p_y, p_z, p_count, p_planes[j]);
+#endif
+		if (any_over) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void gizmo_project_points(const GizmoScreenProjection& p_projection, float* p_x, float* p_y, const float* p_z, int p_count) {
+	float cx = p_projection.center.x;
+	float cy = p_projection.center.y;
+	float sx = p_projection.scale.x;
+	float sy = p_projection.scale.y;
+
+	int i = 0;
+#ifdef GIZMO_SEGMENT_BATCH_SSE2
+	__m128 vcx = _mm_set1_ps(cx);
+	__m128 vcy = _mm_set1_ps(cy);
+	__m128 vsx = _mm_set1_ps(sx);
+	__m128 vsy = _mm_set1_ps(sy);
+	__m128 one = _mm_set1_ps(1.0);
+	__m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= p_count; i += 4) {
+		__m128 w = p_projection.orthogonal ? one : _mm_sub_ps(zero, _mm_loadu_ps(p_z + i));
+		_mm_storeu_ps(p_x + i, _mm_add_ps(vcx, _mm_div_ps(_mm_mul_ps(vsx, _mm_loadu_ps(p_x + i)), w)));
+		_mm_storeu_ps(p_y + i, _mm_add_ps(vcy, _mm_div_ps(_mm_mul_ps(vsy, _mm_loadu_ps(p_y + i)), w)));
+	}
+#endif
+
+	for (; i < p_count; i++) {
+		float w = p_projection.orthogonal ? 1.0f : -p_z[i];
+		p_x[i] = cx + sx * p_x[i] / w;
+		p_y[i] = cy + sy * p_y[i] / w;
+	}
+}
+
+void gizmo_segment_distances_2d(const float* p_ax, const float* p_ay, const float* p_bx, const float* p_by, int p_count, const Vector2& p_point, float* r_distances) {
+	float px = p_point.x;
+	float py = p_point.y;
+
+	int i = 0;
+#ifdef GIZMO_SEGMENT_BATCH_SSE2
+	__m128 vpx = _mm_set1_ps(px);
+	__m128 vpy = _mm_set1_ps(py);
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0);
+	__m128 min_length = _mm_set1_ps(SEGMENT_MIN_LENGTH_SQUARED);
+	for (; i + 4 <= p_count; i += 4) {
+		__m128 ax = _mm_loadu_ps(p_ax + i);
+		__m128 ay = _mm_loadu_ps(p_ay + i);
+		__m128 nx = _mm_sub_ps(_mm_loadu_ps(p_bx + i), ax);
+		__m128 ny = _mm_sub_ps(_mm_loadu_ps(p_by + i), ay);
+		__m128 dx = _mm_sub_ps(vpx, ax);
+		__m128 dy = _mm_sub_ps(vpy, ay);
+
+		// Zero length segments divide by a safe value and are masked back to their first point.
+		__m128 l2 = _mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny));
+		__m128 degenerate = _mm_cmplt_ps(l2, min_length);
+		__m128 t = _mm_div_ps(_mm_add_ps(_mm_mul_ps(nx, dx), _mm_mul_ps(ny, dy)), _mm_max_ps(l2, min_length));
+		t = _mm_andnot_ps(degenerate, _mm_min_ps(_mm_max_ps(t, zero), one));
+
+		__m128 ex = _mm_sub_ps(dx, _mm_mul_ps(nx, t));
+		__m128 ey = _mm_sub_ps(dy, _mm_mul_ps(ny, t));
+		_mm_storeu_ps(r_distances + i, _mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)));
+	}
+#endif
+
+	for (; i < p_count; i++) {
+		float nx = p_bx[i] - p_ax[i];
+		float ny = p_by[i] - p_ay[i];
+		float dx = px - p_ax[i];
+		float dy = py - p_ay[i];
+
+		float l2 = nx * nx + ny * ny;
+		float t = 0;
+		if (l2 >= SEGMENT_MIN_LENGTH_SQUARED) {
+			t = CLAMP((nx * dx + ny * dy) / l2, 0.0f, 1.0f);
+		}
+
+		float ex = dx - nx * t;
+		float ey = dy - ny * t;
+		r_distances[i] = ex * ex + ey * ey;
+	}
+}
@@ -0,0 +1,32 @@
+#ifndef GIZMO_SEGMENT_BATCH_H
+#define GIZMO_SEGMENT_BATCH_H
+
+#include "core/math/plane.h"
+#include "core/math/transform.h"
+#include "core/math/vector2.h"
+
+// Batched tests over the collision segments of a gizmo. Points are transformed once into separate
+// x, y and z arrays, the tests then run over whole arrays, with SSE2 when the CPU has it.
+
+// Transforms p_count points, every p_stride-th one of p_points, by p_xform into r_x, r_y and r_z.
+void gizmo_xform_points(const Transform& p_xform, const Vector3* p_points, int p_stride, int p_count, float* r_x, float* r_y, float* r_z);
+
+// True when none of the points is over any of the planes.
+bool gizmo_points_inside_planes(const float* p_x, const float* p_y, const float* p_z, int p_count, const Plane* p_planes, int p_plane_count);
+
+// Maps camera space points to the screen the way Camera::unproject_position does,
+// x = center.x + scale.x * X / -Z, or without the division for orthogonal cameras.
+struct GizmoScreenProjection {
+	Vector2 center;
+	Vector2 scale;
+	bool orthogonal = false;
+};
+
+// Projects the camera space points in p_x, p_y and p_z to the screen, in place in p_x and p_y.
+void gizmo_project_points(const GizmoScreenProjection& p_projection, float* p_x, float* p_y, const float* p_z, int p_count);
+
+// Squared distances on screen from p_point to the segments from (p_ax, p_ay) to (p_bx, p_by),
+// the same as Geometry::get_closest_point_to_segment_2d would give.
+void gizmo_segment_distances_2d(const float* p_ax, const float* p_ay, const float* p_bx, const float* p_by, int p_count, const Vector2& p_point, float* r_distances);
+
+#endif
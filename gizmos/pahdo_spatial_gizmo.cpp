@@ -1,11 +1,26 @@
 #include "pahdo_spatial_gizmo.h"
 
+#include "gizmo_segment_batch.h"
 #include "pahdo_spatial_gizmo_plugin.h"
 #include "scene/3d/camera.h"
 #include "scene/3d/skeleton.h"
 #include "scene/resources/primitive_meshes.h"
 
 #define HANDLE_HALF_SIZE 9.5
+#define SEGMENT_PICK_DISTANCE 8
+
+// Camera::unproject_position builds the projection matrix on every call, three calls give the whole mapping.
+static GizmoScreenProjection _get_screen_projection(const Camera* p_camera) {
+	Transform camera_xform = p_camera->get_camera_transform();
+	Vector2 center = p_camera->unproject_position(camera_xform.xform(Vector3(0, 0, -1)));
+
+	GizmoScreenProjection projection;
+	projection.center = center;
+	projection.scale.x = p_camera->unproject_position(camera_xform.xform(Vector3(1, 0, -1))).x - center.x;
+	projection.scale.y = p_camera->unproject_position(camera_xform.xform(Vector3(0, 1, -1))).y - center.y;
+	projection.orthogonal = p_camera->get_projection() == Camera::PROJECTION_ORTHOGONAL;
+	return projection;
+}
 
 bool PahdoSpatialGizmo::is_editable() const {
 	ERR_FAIL_COND_V(!spatial_node, false);
@@ -38,6 +53,8 @@ void PahdoSpatialGizmo::clear() {
 	instances.clear();
 	handles.clear();
 	secondary_handles.clear();
+	pick_aabb = AABB();
+	has_pick_aabb = false;
 }
 
 void PahdoSpatialGizmo::redraw() {
@@ -303,8 +320,27 @@ void PahdoSpatialGizmo::add_unscaled_billboard(const Ref<Material>& p_material,
 	instances.push_back(ins);
 }
 
+void PahdoSpatialGizmo::_expand_pick_aabb(const Vector3* p_points, int p_count) {
+	for (int i = 0; i < p_count; i++) {
+		if (has_pick_aabb) {
+			pick_aabb.expand_to(p_points[i]);
+		}
+		else {
+			pick_aabb = AABB(p_points[i], Vector3());
+			has_pick_aabb = true;
+		}
+	}
+}
+
 void PahdoSpatialGizmo::add_collision_triangles(const Ref<TriangleMesh>& p_tmesh) {
 	collision_mesh = p_tmesh;
+	if (p_tmesh.is_valid()) {
+		PoolVector<Face3> faces = p_tmesh->get_faces();
+		PoolVector<Face3>::Read r = faces.read();
+		for (int i = 0; i < faces.size(); i++) {
+			_expand_pick_aabb(r[i].vertex, 3);
+		}
+	}
 }
 
 void PahdoSpatialGizmo::add_collision_segments(const Vector<Vector3>& p_lines) {
@@ -313,6 +349,7 @@ void PahdoSpatialGizmo::add_collision_segments(const Vector<Vector3>& p_lines) {
 	for (int i = 0; i < p_lines.size(); i++) {
 		collision_segments.write[from + i] = p_lines[i];
 	}
+	_expand_pick_aabb(p_lines.ptr(), p_lines.size());
 }
 
 void PahdoSpatialGizmo::add_handles(const Vector<Vector3>& p_handles, const Ref<Material>& p_material, bool p_billboard, bool p_secondary) {
@@ -370,6 +407,7 @@ void PahdoSpatialGizmo::add_handles(const Vector<Vector3>& p_handles, const Ref<
 		VS::get_singleton()->instance_set_transform(ins.instance, spatial_node->get_global_transform());
 	}
 	instances.push_back(ins);
+	_expand_pick_aabb(p_handles.ptr(), p_handles.size());
 	if (!p_secondary) {
 		int chs = handles.size();
 		handles.resize(chs + p_handles.size());
@@ -408,16 +446,61 @@ void PahdoSpatialGizmo::add_solid_box(Ref<Material>& p_material, Vector3 p_size,
 	add_mesh(m);
 }
 
+bool PahdoSpatialGizmo::get_pick_bounds(AABB& r_aabb, float& r_icon_size) const {
+	ERR_FAIL_COND_V(!spatial_node, false);
+
+	// The corners of an icon's square are a bit further out than its size.
+	r_icon_size = selectable_icon_size > 0.0f ? selectable_icon_size * 1.5f : 0.0f;
+	if (!valid || (!has_pick_aabb && r_icon_size == 0.0f)) {
+		return false;
+	}
+
+	Transform t = spatial_node->get_global_transform();
+	if (!has_pick_aabb) {
+		r_aabb = AABB(t.origin, Vector3());
+		return true;
+	}
+
+	if (billboard_handle) {
+		// Billboards turn around the origin to face the camera, without the node's scale.
+		real_t radius = 0;
+		for (int i = 0; i < 8; i++) {
+			radius = MAX(radius, pick_aabb.get_endpoint(i).length());
+		}
+		r_aabb = AABB(t.origin - Vector3(radius, radius, radius), Vector3(radius, radius, radius) * 2.0);
+	}
+	else {
+		r_aabb = t.xform(pick_aabb);
+	}
+
+	if (r_icon_size > 0.0f) {
+		r_aabb.expand_to(t.origin);
+	}
+	return true;
+}
+
+bool PahdoSpatialGizmo::is_selectable() const {
+	return valid && (!hidden || gizmo_plugin->is_selectable_when_hidden());
+}
+
 bool PahdoSpatialGizmo::intersect_frustum(const Camera* p_camera, const Vector<Plane>& p_frustum) {
 	ERR_FAIL_COND_V(!spatial_node, false);
 	ERR_FAIL_COND_V(!valid, false);
 
-	if (hidden && !gizmo_plugin->is_selectable_when_hidden()) {
+	if (!is_selectable()) {
 		return false;
 	}
 
+	Vector<Vector3> convex_points;
+	if (selectable_icon_size <= 0.0f && collision_mesh.is_valid()) {
+		convex_points = Geometry::compute_convex_mesh_points(p_frustum.ptr(), p_frustum.size());
+	}
+	return intersect_frustum_xform(spatial_node->get_global_transform(), p_frustum, convex_points);
+}
+
+bool PahdoSpatialGizmo::intersect_frustum_xform(const Transform& p_global, const Vector<Plane>& p_frustum, const Vector<Vector3>& p_convex_points) const {
 	if (selectable_icon_size > 0.0f) {
-		Vector3 origin = spatial_node->get_global_transform().get_origin();
+		Vector3 origin = p_global.get_origin();
 
 		const Plane* p = p_frustum.ptr();
 		int fc = p_frustum.size();
@@ -435,34 +518,22 @@ bool PahdoSpatialGizmo::intersect_frustum(const Camera* p_camera, const Vector<P
 	}
 
 	if (collision_segments.size()) {
-		const Plane* p = p_frustum.ptr();
-		int fc = p_frustum.size();
-
+		// Every point is transformed once, then tested against all the planes.
 		int vc = collision_segments.size();
-		const Vector3* vptr = collision_segments.ptr();
-		Transform t = spatial_node->get_global_transform();
-
-		bool any_out = false;
-		for (int j = 0; j < fc; j++) {
-			for (int i = 0; i < vc; i++) {
-				Vector3 v = t.xform(vptr[i]);
-				if (p[j].is_point_over(v)) {
-					any_out = true;
-					break;
-				}
-			}
-			if (any_out) {
-				break;
-			}
-		}
-
-		if (!any_out) {
+		Vector<float> points;
+		points.resize(vc * 3);
+		float* x = points.ptrw();
+		float* y = x + vc;
+		float* z = y + vc;
+		gizmo_xform_points(p_global, collision_segments.ptr(), 1, vc, x, y, z);
+
+		if (gizmo_points_inside_planes(x, y, z, vc, p_frustum.ptr(), p_frustum.size())) {
 			return true;
 		}
 	}
 
 	if (collision_mesh.is_valid()) {
-		Transform t = spatial_node->get_global_transform();
+		Transform t = p_global;
 
 		Vector3 mesh_scale = t.get_basis().get_scale();
 		t.orthonormalize();
@@ -475,9 +546,7 @@ bool PahdoSpatialGizmo::intersect_frustum(const Camera* p_camera, const Vector<P
 			transformed_frustum.push_back(it.xform(p_frustum[i]));
 		}
 
-		Vector<Vector3> convex_points = Geometry::compute_convex_mesh_points(p_frustum.ptr(), p_frustum.size());
-
-		if (collision_mesh->inside_convex_shape(transformed_frustum.ptr(), transformed_frustum.size(), convex_points.ptr(), convex_points.size(), mesh_scale)) {
+		if (collision_mesh->inside_convex_shape(transformed_frustum.ptr(), transformed_frustum.size(), p_convex_points.ptr(), p_convex_points.size(), mesh_scale)) {
 			return true;
 		}
 	}
@@ -619,48 +688,70 @@ Dictionary PahdoSpatialGizmo::intersect_ray(const Object* p_camera, const Vector
 	if (!collision_segments.empty()) {
 		Plane camp(camera->get_transform().origin, (-camera->get_transform().basis.get_axis(2)).normalized());
 
-		int vc = collision_segments.size();
+		int sc = collision_segments.size() / 2;
 		const Vector3* vptr = collision_segments.ptr();
 		Transform t = spatial_node->get_global_transform();
 		if (billboard_handle) {
 			t.set_look_at(t.origin, t.origin - camera->get_transform().basis.get_axis(2), camera->get_transform().basis.get_axis(1));
 		}
 
+		// Both ends of every segment go from the node's space to the camera's and onto the screen in
+		// one pass, then the distances to the mouse are measured for all of them at once.
+		Transform view = camera->get_camera_transform().affine_inverse() * t;
+		Vector<float> buffer;
+		buffer.resize(sc * 7);
+		float* ax = buffer.ptrw();
+		float* ay = ax + sc;
+		float* az = ay + sc;
+		float* bx = az + sc;
+		float* by = bx + sc;
+		float* bz = by + sc;
+		float* distances = bz + sc;
+
+		GizmoScreenProjection projection = _get_screen_projection(camera);
+		gizmo_xform_points(view, vptr, 2, sc, ax, ay, az);
+		gizmo_xform_points(view, vptr + 1, 2, sc, bx, by, bz);
+		gizmo_project_points(projection, ax, ay, az, sc);
+		gizmo_project_points(projection, bx, by, bz, sc);
+		gizmo_segment_distances_2d(ax, ay, bx, by, sc, p_point, distances);
+
 		Vector3 cp;
-		float cpd = 1e20;
+		float cpd = SEGMENT_PICK_DISTANCE * SEGMENT_PICK_DISTANCE;
+		bool found = false;
+
+		// Only the segments closer than the ones before them need their point in space.
+		for (int i = 0; i < sc; i++) {
+			if (!(distances[i] < cpd)) {
+				continue;
+			}
 
-		for (int i = 0; i < vc / 2; i++) {
-			Vector3 a = t.xform(vptr[i * 2 + 0]);
-			Vector3 b = t.xform(vptr[i * 2 + 1]);
 			Vector2 s[2];
-			s[0] = camera->unproject_position(a);
-			s[1] = camera->unproject_position(b);
+			s[0] = Vector2(ax[i], ay[i]);
+			s[1] = Vector2(bx[i], by[i]);
 
 			Vector2 p = Geometry::get_closest_point_to_segment_2d(p_point, s);
 
-			float pd = p.distance_to(p_point);
-
-			if (pd < cpd) {
-				float d = s[0].distance_to(s[1]);
-				Vector3 tcp;
-				if (d > 0) {
-					float d2 = s[0].distance_to(p) / d;
-					tcp = a + (b - a) * d2;
-
-				}
-				else {
-					tcp = a;
-				}
+			Vector3 a = t.xform(vptr[i * 2 + 0]);
+			Vector3 b = t.xform(vptr[i * 2 + 1]);
+			float d = s[0].distance_to(s[1]);
+			Vector3 tcp;
+			if (d > 0) {
+				float d2 = s[0].distance_to(p) / d;
+				tcp = a + (b - a) * d2;
+			}
+			else {
+				tcp = a;
+			}
 
-				if (camp.distance_to(tcp) < camera->get_znear()) {
-					continue;
-				}
-				cp = tcp;
-				cpd = pd;
+			if (camp.distance_to(tcp) < camera->get_znear()) {
+				continue;
 			}
+			cp = tcp;
+			cpd = distances[i];
+			found = true;
 		}
 
-		if (cpd < 8) {
+		if (found) {
 			r_pos = cp;
 			r_normal = -camera->project_ray_normal(p_point);
 
@@ -719,6 +810,7 @@ void PahdoSpatialGizmo::transform() {
 	for (int i = 0; i < instances.size(); i++) {
 		VS::get_singleton()->instance_set_transform(instances[i].instance, spatial_node->get_global_transform());
 	}
+	emit_signal("transformed");
 }
 
 void PahdoSpatialGizmo::free() {
@@ -772,6 +864,8 @@ void PahdoSpatialGizmo::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_handle_value", "index"), &PahdoSpatialGizmo::get_handle_value);
 	ClassDB::bind_method(D_METHOD("set_handle", "index", "camera", "point"), &PahdoSpatialGizmo::set_handle);
 	ClassDB::bind_method(D_METHOD("commit_handle", "index", "restore", "cancel"), &PahdoSpatialGizmo::commit_handle, DEFVAL(false));
+
+	ADD_SIGNAL(MethodInfo("transformed"));
 }
 
 PahdoSpatialGizmo::PahdoSpatialGizmo() {
@@ -784,6 +878,7 @@ PahdoSpatialGizmo::PahdoSpatialGizmo() {
 	spatial_node = nullptr;
 	gizmo_plugin = nullptr;
 	selectable_icon_size = -1.0f;
+	has_pick_aabb = false;
 }
 
 PahdoSpatialGizmo::~PahdoSpatialGizmo() {
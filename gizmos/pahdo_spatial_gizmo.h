@@ -49,6 +49,12 @@ public:
 	float selectable_icon_size;
 	bool billboard_handle;
 
+	// Local bounds of everything intersect_ray tests, handles, collision segments and triangles.
+	AABB pick_aabb;
+	bool has_pick_aabb;
+
+	void _expand_pick_aabb(const Vector3* p_points, int p_count);
+
 	bool valid;
 	bool hidden;
 	Spatial* base;
@@ -81,7 +87,16 @@ public:
 	Spatial* get_spatial_node() const { return spatial_node; }
 	Ref<PahdoSpatialGizmoPlugin> get_plugin() const { return gizmo_plugin; }
 	Vector3 get_handle_pos(int p_idx) const;
+	// World bounds of what intersect_ray can hit, false when nothing can be hit. Icons only add their
+	// origin, r_icon_size is how far they reach per unit of distance from the camera.
+	bool get_pick_bounds(AABB& r_aabb, float& r_icon_size) const;
 	bool intersect_frustum(const Camera* p_camera, const Vector<Plane>& p_frustum);
+	// False when the gizmo can't be selected at all, may ask the plugin's script so it stays on the main thread.
+	bool is_selectable() const;
+	// The tests of intersect_frustum against a node transform read beforehand. Only reads the gizmo, so
+	// several gizmos can be tested on worker threads. p_convex_points are the frustum's corners, they are
+	// only needed for collision triangles.
+	bool intersect_frustum_xform(const Transform& p_global, const Vector<Plane>& p_frustum, const Vector<Vector3>& p_convex_points) const;
 	Dictionary intersect_ray(const Object *p_camera, const Vector2 &p_point, bool p_sec_first = false) const;
 
 	virtual void clear();
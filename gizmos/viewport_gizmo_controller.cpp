@@ -2,13 +2,36 @@
 
 #include "pahdo_spatial_gizmo_plugin.h"
 #include "content_editor/editor_consts.h"
+#include "core/math/geometry.h"
+#include "core/os/threaded_array_processor.h"
 #include "scene/3d/camera.h"
 #include "scene/gui/viewport_container.h"
 #include "scene/resources/surface_tool.h"
 
+void ViewportGizmoController::_refresh_controller_state() {
+	selected = cast_to<Spatial>(controller->get(selected_property));
+	camera = cast_to<Camera>(controller->get(camera_property));
+	current_mode = controller->get(current_mode_property);
+
+	ViewportContainer* container = cast_to<ViewportContainer>(controller);
+	stretch_shrink = container ? container->get_stretch_shrink() : static_cast<int>(controller->call(get_stretch_shrink_method));
+
+	// The controller changed its selection by itself, it only knows about a single node.
+	if (!selected ? !selection.empty() : selection.find(selected) == -1) {
+		_set_selection(selected);
+	}
+}
+
+void ViewportGizmoController::refresh_controller_state() {
+	if (controller) {
+		_refresh_controller_state();
+	}
+}
+
 void ViewportGizmoController::update_all_gizmos(const Object* p_node) {
+	_refresh_controller_state();
 	if (!p_node) {
-		p_node = cast_to<Node>(controller->get("selected"));
+		p_node = selected;
 	}
 	if (!p_node) {
 		return;
@@ -17,11 +40,16 @@ void ViewportGizmoController::update_all_gizmos(const Object* p_node) {
 }
 
 void ViewportGizmoController::update_transform_gizmo() {
+	_refresh_controller_state();
+	_update_transform_gizmo();
+}
+
+void ViewportGizmoController::_update_transform_gizmo() {
 	AABB center;
 	Basis gizmo_basis;
 	bool local_gizmo_coords = false;
 
-	if (controller->get("selected")) {
+	if (selected) {
 		Transform xf = get_global_gizmo_transform();
 
 		center.position = xf.origin;
@@ -50,10 +78,10 @@ bool ViewportGizmoController::_gizmo_select(const Vector2& p_screenpos, bool p_h
 	Vector3 ray_pos = _get_ray_pos(p_screenpos);
 	Vector3 ray = _get_ray(p_screenpos);
 
-	Transform gt = get_gizmo_transform();
+	Transform gt = get_global_gizmo_transform();
 	float gs = gizmo_scale;
 
-	if (static_cast<int>(controller->get("current_mode")) & MOVE_MODE) {
+	if (current_mode & MOVE_MODE) {
 		int col_axis = -1;
 		float col_d = 1e20;
 
@@ -111,7 +139,7 @@ bool ViewportGizmoController::_gizmo_select(const Vector2& p_screenpos, bool p_h
 		}
 	}
 
-	if (static_cast<int>(controller->get("current_mode")) & ROTATE_MODE) {
+	if (current_mode & ROTATE_MODE) {
 		int col_axis = -1;
 		float col_d = 1e20;
 
@@ -167,10 +195,12 @@ void ViewportGizmoController::_request_gizmo(Spatial* p_spatial) {
 
 		if (spg.is_valid()) {
 			gizmos_by_node.insert(p_spatial, GizmoInfo{ false, spg });
+			spg->connect("transformed", this, "_gizmo_transformed", varray(p_spatial));
+			pick_dirty.insert(p_spatial);
 
-			if (p_spatial == controller->get("selected")) {
+			if (selection.find(p_spatial) != -1) {
 				spg->set_selected(true);
-				update_gizmo(cast_to<Spatial>(controller->get("selected")));
+				update_gizmo(p_spatial);
 				spg->create();
 				if (p_spatial->is_visible_in_tree()) {
 					spg->redraw();
@@ -211,8 +241,8 @@ void ViewportGizmoController::update_transform_gizmo_view() {
 		return;
 	}
 
-	Transform xform = get_gizmo_transform();
-	Transform camera_xform = cast_to<Camera>(controller->get("camera"))->get_transform();
+	Transform xform = get_global_gizmo_transform();
+	Transform camera_xform = camera->get_transform();
 
 	if (xform.origin.distance_squared_to(camera_xform.origin) < 0.01) {
 		for (int i = 0; i < 3; ++i) {
@@ -228,8 +258,8 @@ void ViewportGizmoController::update_transform_gizmo_view() {
 	Vector3 camy = -camera_xform.basis.get_axis(1).normalized();
 	Plane p(camera_xform.origin, camz);
 	float gizmo_d = MAX(abs(p.distance_to(xform.origin)), 0.00001);
-	float d0 = cast_to<Camera>(controller->get("camera"))->unproject_position(camera_xform.origin + camz * gizmo_d).y;
-	float d1 = cast_to<Camera>(controller->get("camera"))->unproject_position(camera_xform.origin + camz * gizmo_d + camy).y;
+	float d0 = camera->unproject_position(camera_xform.origin + camz * gizmo_d).y;
+	float d1 = camera->unproject_position(camera_xform.origin + camz * gizmo_d + camy).y;
 	float dd = abs(d0 - d1);
 	if (dd == 0) {
 		dd = 0.0001;
@@ -237,19 +267,19 @@ void ViewportGizmoController::update_transform_gizmo_view() {
 
 	float gizmo_size = _EditorConsts::get_singleton()->named_const("gizmo_size", 80);
 	int viewport_base_height = 400;
-	gizmo_scale = gizmo_size / abs(dd) * 1 * MIN(viewport_base_height, controller->get_size().height) / viewport_base_height / static_cast<int>(controller->call("get_stretch_shrink"));
+	gizmo_scale = gizmo_size / abs(dd) * 1 * MIN(viewport_base_height, controller->get_size().height) / viewport_base_height / stretch_shrink;
 	Vector3 scale = Vector3(1, 1, 1) * gizmo_scale;
 
 	xform.basis = xform.basis.scaled(scale);
 
 	for (int i = 0; i < 3; ++i) {
 		VS::get_singleton()->instance_set_transform(move_gizmo_instance[i], xform);
-		VS::get_singleton()->instance_set_visible(move_gizmo_instance[i], is_gizmo_visible() && static_cast<int>(controller->get("current_mode")) & MOVE_MODE);
+		VS::get_singleton()->instance_set_visible(move_gizmo_instance[i], is_gizmo_visible() && current_mode & MOVE_MODE);
 		VS::get_singleton()->instance_set_transform(rotate_gizmo_instance[i], xform);
-		VS::get_singleton()->instance_set_visible(rotate_gizmo_instance[i], is_gizmo_visible() && static_cast<int>(controller->get("current_mode")) & ROTATE_MODE);
+		VS::get_singleton()->instance_set_visible(rotate_gizmo_instance[i], is_gizmo_visible() && current_mode & ROTATE_MODE);
 	}
 	VS::get_singleton()->instance_set_transform(rotate_gizmo_instance[3], xform);
-	VS::get_singleton()->instance_set_visible(rotate_gizmo_instance[3], is_gizmo_visible() && static_cast<int>(controller->get("current_mode")) & ROTATE_MODE);
+	VS::get_singleton()->instance_set_visible(rotate_gizmo_instance[3], is_gizmo_visible() && current_mode & ROTATE_MODE);
 }
 
 void ViewportGizmoController::_update_gizmo(const Object* p_spatial) {
@@ -259,19 +289,251 @@ void ViewportGizmoController::_update_gizmo(const Object* p_spatial) {
 	}
 	gizmos_by_node[spatial].gizmo_dirty = false;
 	if (gizmos_by_node[spatial].gizmo.is_valid()) {
-		if (spatial->is_visible_in_tree() && static_cast<int>(controller->get("current_mode")) & WIDGET_MODE) {
+		if (spatial->is_visible_in_tree() && current_mode & WIDGET_MODE) {
 			gizmos_by_node[spatial].gizmo->redraw();
 		}
 		else {
 			gizmos_by_node[spatial].gizmo->clear();
 		}
 	}
+	pick_dirty.insert(spatial);
+}
+
+void ViewportGizmoController::_gizmo_transformed(Object* p_spatial) {
+	Spatial* spatial = cast_to<Spatial>(p_spatial);
+	if (spatial && gizmos_by_node.has(spatial)) {
+		pick_dirty.insert(spatial);
+	}
+}
+
+void ViewportGizmoController::_refit_pick_tree() {
+	for (Set<Spatial*>::Element* E = pick_dirty.front(); E; E = E->next()) {
+		Map<Spatial*, GizmoInfo>::Element* info = gizmos_by_node.find(E->get());
+		if (!info) {
+			continue;
+		}
+
+		GizmoInfo& gi = info->get();
+		AABB aabb;
+		float icon_size = 0;
+		if (gi.gizmo.is_valid() && gi.gizmo->get_pick_bounds(aabb, icon_size)) {
+			if (gi.pick_leaf == -1) {
+				gi.pick_leaf = pick_tree.insert(aabb, icon_size, E->get()->get_instance_id());
+			}
+			else {
+				pick_tree.update(gi.pick_leaf, aabb, icon_size);
+			}
+		}
+		else if (gi.pick_leaf != -1) {
+			pick_tree.remove(gi.pick_leaf);
+			gi.pick_leaf = -1;
+		}
+	}
+	pick_dirty.clear();
+}
+
+Spatial* ViewportGizmoController::_pick_gizmo(const Vector2& p_screenpos) {
+	if (!camera) {
+		return nullptr;
+	}
+
+	_refit_pick_tree();
+	if (pick_tree.empty()) {
+		return nullptr;
+	}
+
+	// Turn the pixel margin into world units, per unit of distance from the camera, or once for
+	// orthogonal cameras, where icons are scaled the same way intersect_ray does.
+	Size2 viewport_size = camera->get_viewport()->get_visible_rect().size;
+	float pixels = MAX(1.0f, MIN(viewport_size.x, viewport_size.y));
+	float margin;
+	float fixed_scale = 0;
+	if (camera->get_projection() == Camera::PROJECTION_ORTHOGONAL) {
+		fixed_scale = camera->get_size() / MAX(CMP_EPSILON, viewport_size.aspect());
+		margin = GIZMO_PICK_MARGIN * camera->get_size() / pixels / fixed_scale;
+	}
+	else {
+		margin = GIZMO_PICK_MARGIN * 2.0 * Math::tan(Math::deg2rad(camera->get_fov()) * 0.5) / pixels;
+	}
+
+	Vector<ObjectID> candidates;
+	pick_tree.query_ray(camera->project_ray_origin(p_screenpos), camera->project_ray_normal(p_screenpos), margin, fixed_scale, candidates);
+
+	// Only the few gizmos near the ray get the exact test, which projects their parts to the screen.
+	Vector3 camera_pos = camera->get_camera_transform().origin;
+	Spatial* nearest = nullptr;
+	float nearest_d = 1e20;
+	for (int i = 0; i < candidates.size(); i++) {
+		Spatial* spatial = cast_to<Spatial>(ObjectDB::get_instance(candidates[i]));
+		if (!spatial || !gizmos_by_node.has(spatial)) {
+			continue;
+		}
+
+		Dictionary inters = gizmos_by_node[spatial].gizmo->intersect_ray(camera, p_screenpos);
+		if (inters.empty()) {
+			continue;
+		}
+
+		float d = camera_pos.distance_to(inters["pos"]);
+		if (d < nearest_d) {
+			nearest_d = d;
+			nearest = spatial;
+		}
+	}
+	return nearest;
+}
+
+Object* ViewportGizmoController::pick_gizmo(const Vector2& p_point) {
+	_refresh_controller_state();
+	return _pick_gizmo(p_point);
+}
+
+Vector<Plane> ViewportGizmoController::_get_frustum(const Rect2& p_rect) {
+	Vector<Plane> frustum;
+	Vector3 camera_pos = camera->get_camera_transform().origin;
+	bool orthogonal = camera->get_projection() == Camera::PROJECTION_ORTHOGONAL;
+	float z_near = camera->get_znear();
+
+	// The corners go clockwise on screen, so every plane faces away from the rectangle.
+	Point2 begin = p_rect.position;
+	Point2 end = p_rect.position + p_rect.size;
+	Point2 box[4] = { begin, Point2(end.x, begin.y), end, Point2(begin.x, end.y) };
+	for (int i = 0; i < 4; i++) {
+		Vector3 a = camera->project_position(box[i], z_near);
+		Vector3 b = camera->project_position(box[(i + 1) % 4], z_near);
+		if (orthogonal) {
+			frustum.push_back(Plane(a, (a - b).normalized()));
+		}
+		else {
+			frustum.push_back(Plane(a, b, camera_pos));
+		}
+	}
+
+	Plane near_plane(camera_pos, -_get_camera_normal());
+	near_plane.d -= z_near;
+	frustum.push_back(near_plane);
+
+	Plane far_plane = -near_plane;
+	far_plane.d += camera->get_zfar();
+	frustum.push_back(far_plane);
+
+	return frustum;
+}
+
+void ViewportGizmoController::_box_select_candidate(uint32_t p_index, BoxSelectData* p_data) {
+	BoxSelectCandidate& candidate = p_data->candidates[p_index];
+	candidate.hit = candidate.gizmo->intersect_frustum_xform(candidate.global, p_data->frustum, p_data->convex_points);
+}
+
+void ViewportGizmoController::_box_select(const Rect2& p_rect, bool p_add) {
+	if (!camera || p_rect.has_no_area()) {
+		return;
+	}
+
+	_refit_pick_tree();
+
+	BoxSelectData data;
+	data.frustum = _get_frustum(p_rect);
+
+	Vector<ObjectID> ids;
+	pick_tree.query_frustum(data.frustum, ids);
+
+	// Transforms and the plugins' scripts are read here, so the exact tests only read plain data.
+	Vector<BoxSelectCandidate> candidates;
+	bool needs_convex_points = false;
+	for (int i = 0; i < ids.size(); i++) {
+		Spatial* spatial = cast_to<Spatial>(ObjectDB::get_instance(ids[i]));
+		Map<Spatial*, GizmoInfo>::Element* info = spatial ? gizmos_by_node.find(spatial) : nullptr;
+		if (!info || !info->get().gizmo.is_valid() || !info->get().gizmo->is_selectable()) {
+			continue;
+		}
+
+		BoxSelectCandidate candidate;
+		candidate.spatial = spatial;
+		candidate.gizmo = info->get().gizmo.ptr();
+		candidate.global = spatial->get_global_transform();
+		candidate.hit = false;
+		candidates.push_back(candidate);
+
+		needs_convex_points = needs_convex_points || info->get().gizmo->collision_mesh.is_valid();
+	}
+
+	if (needs_convex_points) {
+		data.convex_points = Geometry::compute_convex_mesh_points(data.frustum.ptr(), data.frustum.size());
+	}
+	data.candidates = candidates.ptrw();
+
+	// Starting threads costs more than testing a few gizmos.
+	if (candidates.size() >= BOX_SELECT_THREADED_MIN) {
+		thread_process_array(candidates.size(), this, &ViewportGizmoController::_box_select_candidate, &data);
+	}
+	else {
+		for (int i = 0; i < candidates.size(); i++) {
+			_box_select_candidate(i, &data);
+		}
+	}
+
+	Set<Spatial*> kept;
+	if (p_add) {
+		for (int i = 0; i < selection.size(); i++) {
+			kept.insert(selection[i]);
+		}
+	}
+	else {
+		Set<Spatial*> hits;
+		for (int i = 0; i < candidates.size(); i++) {
+			if (candidates[i].hit) {
+				hits.insert(candidates[i].spatial);
+			}
+		}
+
+		Vector<Spatial*> previous = selection;
+		selection.clear();
+		for (int i = 0; i < previous.size(); i++) {
+			if (hits.has(previous[i])) {
+				selection.push_back(previous[i]);
+				kept.insert(previous[i]);
+			}
+			else {
+				_set_gizmo_selected(previous[i], false);
+			}
+		}
+	}
+
+	for (int i = 0; i < candidates.size(); i++) {
+		if (candidates[i].hit && !kept.has(candidates[i].spatial)) {
+			selection.push_back(candidates[i].spatial);
+			kept.insert(candidates[i].spatial);
+			_set_gizmo_selected(candidates[i].spatial, true);
+		}
+	}
+
+	// The active node stays when it is still selected.
+	Spatial* active = selection.find(selected) != -1 ? selected : (selection.empty() ? nullptr : selection[selection.size() - 1]);
+	controller->set(selected_property, active);
+	selected = active;
+	over_gizmo_handle = -1;
+	_update_transform_gizmo();
+}
+
+void ViewportGizmoController::box_select(const Rect2& p_rect, bool p_add) {
+	_refresh_controller_state();
+	_box_select(p_rect.abs(), p_add);
+}
+
+void ViewportGizmoController::_box_selection_draw() {
+	const Rect2 selection_rect = Rect2(Point2(), box_selection->get_size());
+	box_selection->draw_rect(selection_rect, _EditorConsts::BOX_SELECTION_FILL_COLOR);
+	box_selection->draw_rect(selection_rect, _EditorConsts::BOX_SELECTION_STROKE_COLOR, false, Math::round(1.0));
 }
 
 void ViewportGizmoController::_on_other_transform_changed() {
 	if (!self_emitted) {
-		update_all_gizmos(controller->get("selected"));
-		update_transform_gizmo();
+		_refresh_controller_state();
+		for (int i = 0; i < selection.size(); i++) {
+			update_gizmo(selection[i]);
+		}
+		_update_transform_gizmo();
 	}
 }
 
@@ -551,11 +813,18 @@ void ViewportGizmoController::_init_transform() {
 }
 
 void ViewportGizmoController::gui_input(const Ref<InputEvent> p_event) {
-	Spatial* selected = cast_to<Spatial>(controller->get("selected"));
+	// Mouse motion comes in a lot, this is the only time it asks the controller for anything.
+	_refresh_controller_state();
+
 	Ref<InputEventMouseButton> mb = p_event;
 	if (mb.is_valid()) {
 		switch (mb->get_button_index()) {
 		case BUTTON_RIGHT:
+			if (mb->is_pressed() && box_selecting) {
+				box_selection->hide();
+				box_selecting = false;
+			}
+
 			if (mb->is_pressed() && _edit.gizmo.is_valid()) {
 				_edit.gizmo->commit_handle(_edit.gizmo_handle, _edit.gizmo_initial_value, true);
 				_edit.gizmo = Ref<PahdoSpatialGizmo>();
@@ -564,11 +833,9 @@ void ViewportGizmoController::gui_input(const Ref<InputEvent> p_event) {
 			if (_edit.mode != TRANSFORM_NONE && mb->is_pressed()) {
 				_edit.mode = TRANSFORM_NONE;
 
-				if (selected) {
-					selected->set_transform(original_transform);
-					self_emitted = true;
-					emit_signal("transform_changed");
-					self_emitted = false;
+				if (!selection.empty()) {
+					_restore_selection_transforms();
+					_queue_transform_changed();
 				}
 			}
 			break;
@@ -605,7 +872,7 @@ void ViewportGizmoController::gui_input(const Ref<InputEvent> p_event) {
 						seg = gizmos_by_node[selected].gizmo;
 					}
 					if (seg.is_valid()) {
-						Dictionary inters = seg->intersect_ray(controller->get("camera"), _edit.mouse_pos, mb->get_shift());
+						Dictionary inters = seg->intersect_ray(camera, _edit.mouse_pos, mb->get_shift());
 						if (!inters.empty() && static_cast<int>(inters["handle"]) != -1) {
 							_edit.gizmo = seg;
 							_edit.gizmo_handle = inters["handle"];
@@ -619,7 +886,23 @@ void ViewportGizmoController::gui_input(const Ref<InputEvent> p_event) {
 					return;
 				}
 
-				/*if (static_cast<int>(controller->get("current_mode")) & ROTATE_MODE) {
+				Spatial* picked = _pick_gizmo(_get_viewport_pos(_edit.mouse_pos));
+				if (picked) {
+					if (mb->get_shift()) {
+						add_to_selection(picked);
+					}
+					else {
+						edit(picked);
+					}
+					return;
+				}
+
+				// Dragging from empty space draws a box, the nodes inside are selected once it is released.
+				box_selecting = true;
+				box_selecting_from = _edit.mouse_pos;
+				box_select_rect = Rect2();
+
+				/*if (current_mode & ROTATE_MODE) {
 					if (get_selected_count() == 0) {
 						return;
 					}
@@ -628,7 +911,7 @@ void ViewportGizmoController::gui_input(const Ref<InputEvent> p_event) {
 					return;
 				}
 
-				if (static_cast<int>(controller->get("current_mode")) & MOVE_MODE) {
+				if (current_mode & MOVE_MODE) {
 					if (get_selected_count() == 0) {
 						return;
 					}
@@ -638,20 +921,28 @@ void ViewportGizmoController::gui_input(const Ref<InputEvent> p_event) {
 				}*/
 			}
 			else {
+				if (box_selecting) {
+					// Only if moved, a click on empty space leaves the selection alone.
+					if (box_selection->is_visible()) {
+						Vector2 begin = _get_viewport_pos(box_select_rect.position);
+						_box_select(Rect2(begin, _get_viewport_pos(box_select_rect.position + box_select_rect.size) - begin), mb->get_shift());
+						box_selection->hide();
+					}
+					box_selecting = false;
+				}
+
 				if (_edit.gizmo.is_valid()) {
 					_edit.gizmo->commit_handle(_edit.gizmo_handle, _edit.gizmo_initial_value, false);
 					_edit.gizmo = Ref<PahdoSpatialGizmo>();
 				}
 
 				if (_edit.mode != TRANSFORM_NONE) {
-					if (!selected) {
+					if (selection.empty()) {
 						return;
 					}
 
-					selected->set_transform(get_global_gizmo_transform());
-					self_emitted = true;
-					emit_signal("transform_changed");
-					self_emitted = false;
+					// The drag already moved the selection, listeners hear about it once for all of it.
+					_queue_transform_changed();
 					_edit.mode = TRANSFORM_NONE;
 				}
 			}
@@ -663,11 +954,36 @@ void ViewportGizmoController::gui_input(const Ref<InputEvent> p_event) {
 	if (mm.is_valid()) {
 		_edit.mouse_pos = mm->get_position();
 
+		if (box_selecting) {
+			if ((mm->get_button_mask() & BUTTON_MASK_LEFT) == 0) {
+				// Released outside of the viewport.
+				box_selection->hide();
+				box_selecting = false;
+				return;
+			}
+
+			Vector2 from = box_selecting_from;
+			Vector2 to = _edit.mouse_pos;
+			if (from.x > to.x) {
+				SWAP(from.x, to.x);
+			}
+			if (from.y > to.y) {
+				SWAP(from.y, to.y);
+			}
+
+			box_select_rect = Rect2(Point2(), controller->get_size()).clip(Rect2(from, to - from));
+			box_selection->set_position(box_select_rect.position);
+			box_selection->set_size(box_select_rect.size);
+			box_selection->show();
+			box_selection->update();
+			return;
+		}
+
 		if (selected) {
 			Ref<PahdoSpatialGizmo> seg = gizmos_by_node.has(selected) ? gizmos_by_node[selected].gizmo : nullptr;
 			if (seg.is_valid()) {
 				int selected_handle = -1;
-				Dictionary inters = seg->intersect_ray(cast_to<Camera>(controller->get("camera")), _edit.mouse_pos, false);
+				Dictionary inters = seg->intersect_ray(camera, _edit.mouse_pos, false);
 				if (!inters.empty() && static_cast<int>(inters["handle"]) != -1) {
 					selected_handle = inters["handle"];
 				}
@@ -687,8 +1003,8 @@ void ViewportGizmoController::gui_input(const Ref<InputEvent> p_event) {
 		}
 
 		if (_edit.gizmo.is_valid()) {
-			_edit.gizmo->set_handle(_edit.gizmo_handle, controller->get("camera"), mm->get_position());
-			update_all_gizmos(selected);
+			_edit.gizmo->set_handle(_edit.gizmo_handle, camera, mm->get_position());
+			_update_all_gizmos(selected);
 		}
 		else if (mm->get_button_mask() & BUTTON_MASK_LEFT) {
 			if (_edit.mode == TRANSFORM_NONE) {
@@ -696,6 +1012,8 @@ void ViewportGizmoController::gui_input(const Ref<InputEvent> p_event) {
 			}
 			Vector3 ray_pos = _get_ray_pos(mm->get_position());
 			Vector3 ray = _get_ray(mm->get_position());
+			// Axes of the drag planes, in the same global space as the rays and the pivot.
+			Basis gizmo_basis = get_global_gizmo_transform().basis;
 
 			switch (_edit.mode) {
 			case TRANSFORM_TRANSLATE: {
@@ -708,30 +1026,30 @@ void ViewportGizmoController::gui_input(const Ref<InputEvent> p_event) {
 					plane = Plane(_edit.center, _get_camera_normal());
 					break;
 				case TRANSFORM_X_AXIS:
-					motion_mask = get_gizmo_transform().basis.get_axis(0);
+					motion_mask = gizmo_basis.get_axis(0);
 					plane = Plane(_edit.center, motion_mask.cross(motion_mask.cross(_get_camera_normal())).normalized());
 					break;
 				case TRANSFORM_Y_AXIS:
-					motion_mask = get_gizmo_transform().basis.get_axis(1);
+					motion_mask = gizmo_basis.get_axis(1);
 					plane = Plane(_edit.center, motion_mask.cross(motion_mask.cross(_get_camera_normal())).normalized());
 					break;
 				case TRANSFORM_Z_AXIS:
-					motion_mask = get_gizmo_transform().basis.get_axis(2);
+					motion_mask = gizmo_basis.get_axis(2);
 					plane = Plane(_edit.center, motion_mask.cross(motion_mask.cross(_get_camera_normal())).normalized());
 					break;
 				case TRANSFORM_YZ:
-					motion_mask = get_gizmo_transform().basis.get_axis(2) + get_gizmo_transform().basis.get_axis(1);
-					plane = Plane(_edit.center, get_gizmo_transform().basis.get_axis(0));
+					motion_mask = gizmo_basis.get_axis(2) + gizmo_basis.get_axis(1);
+					plane = Plane(_edit.center, gizmo_basis.get_axis(0));
 					plane_mv = true;
 					break;
 				case TRANSFORM_XZ:
-					motion_mask = get_gizmo_transform().basis.get_axis(2) + get_gizmo_transform().basis.get_axis(0);
-					plane = Plane(_edit.center, get_gizmo_transform().basis.get_axis(1));
+					motion_mask = gizmo_basis.get_axis(2) + gizmo_basis.get_axis(0);
+					plane = Plane(_edit.center, gizmo_basis.get_axis(1));
 					plane_mv = true;
 					break;
 				case TRANSFORM_XY:
-					motion_mask = get_gizmo_transform().basis.get_axis(0) + get_gizmo_transform().basis.get_axis(1);
-					plane = Plane(_edit.center, get_gizmo_transform().basis.get_axis(2));
+					motion_mask = gizmo_basis.get_axis(0) + gizmo_basis.get_axis(1);
+					plane = Plane(_edit.center, gizmo_basis.get_axis(2));
 					plane_mv = true;
 					break;
 				}
@@ -753,36 +1071,24 @@ void ViewportGizmoController::gui_input(const Ref<InputEvent> p_event) {
 					}
 				}
 
-				if (!selected) {
-					return;
-				}
-
-				Transform t = original_transform;
-				t.origin += motion;
-				selected->set_transform(t);
-				update_all_gizmos(selected);
-				update_transform_gizmo();
+				_apply_selection_transform(Transform(Basis(), motion));
 
 			} break;
 			case TRANSFORM_ROTATE: {
 				Plane plane;
-				Vector3 axis;
 
 				switch (_edit.plane) {
 				case TRANSFORM_VIEW:
 					plane = Plane(_edit.center, _get_camera_normal());
 					break;
 				case TRANSFORM_X_AXIS:
-					plane = Plane(_edit.center, get_gizmo_transform().basis.get_axis(0));
-					axis = Vector3(1, 0, 0);
+					plane = Plane(_edit.center, gizmo_basis.get_axis(0));
 					break;
 				case TRANSFORM_Y_AXIS:
-					plane = Plane(_edit.center, get_gizmo_transform().basis.get_axis(1));
-					axis = Vector3(0, 1, 0);
+					plane = Plane(_edit.center, gizmo_basis.get_axis(1));
 					break;
 				case TRANSFORM_Z_AXIS:
-					plane = Plane(_edit.center, get_gizmo_transform().basis.get_axis(2));
-					axis = Vector3(0, 0, 1);
+					plane = Plane(_edit.center, gizmo_basis.get_axis(2));
 					break;
 				}
 
@@ -800,32 +1106,11 @@ void ViewportGizmoController::gui_input(const Ref<InputEvent> p_event) {
 				Vector3 x_axis = plane.normal.cross(y_axis).normalized();
 
 				float angle = Math::atan2(x_axis.dot(inters - _edit.center), y_axis.dot(inters - _edit.center));
-				bool local_coords = _edit.plane != TRANSFORM_VIEW;
-
-				Transform t;
-
-				if (local_coords) {
-					Transform original_local = original_transform;
-					Basis rot = Basis(axis, angle);
-
-					t.basis = original_local.basis.orthonormalized() * rot;
-					t.origin = original_local.origin;
-
-					selected->set_transform(t);
-					selected->scale(original_transform.basis.get_scale());
-				}
-				else {
-					Transform original = original_transform;
-					Transform r = Transform();
-					Transform base = Transform(Basis(), _edit.center);
 
-					r.basis = r.basis.rotated(plane.normal, angle);
-					t = base * r * base.inverse() * original;
-
-					selected->set_transform(t);
-				}
-				update_all_gizmos(selected);
-				update_transform_gizmo();
+				// Local axes are the plane normals already, so both cases turn the selection around the pivot.
+				Transform r = Transform(Basis(plane.normal.normalized(), angle));
+				Transform base = Transform(Basis(), _edit.center);
+				_apply_selection_transform(base * r * base.inverse());
 			} break;
 			}
 		}
@@ -863,11 +1148,23 @@ void ViewportGizmoController::_init_gizmo_instance() {
 void ViewportGizmoController::set_viewport_controller(const Object* p_controller) {
 	controller = const_cast<Control*>(cast_to<Control>(p_controller));
 	if (controller) {
+		_refresh_controller_state();
 		if (get_script_instance() && get_script_instance()->has_method("register_all_gizmos")) {
 			get_script_instance()->call("register_all_gizmos");
 		}
 		_init_indicators();
 		_init_gizmo_instance();
+
+		if (box_selection && ObjectDB::instance_validate(box_selection)) {
+			box_selection->queue_delete();
+		}
+		box_selection = memnew(Control);
+		box_selection->set_mouse_filter(Control::MOUSE_FILTER_IGNORE);
+		box_selection->hide();
+		box_selection->connect("draw", this, "_box_selection_draw");
+		// The controller may still be setting up its children.
+		controller->call_deferred("add_child", box_selection);
+		box_selecting = false;
 	}
 }
 
@@ -906,45 +1203,110 @@ void ViewportGizmoController::_finish_gizmo_instances() {
 	VS::get_singleton()->free(rotate_gizmo_instance[3]);
 }
 
-int ViewportGizmoController::get_selected_count() {
-	Node* selected = cast_to<Node>(controller->get("selected"));
-	return selected != nullptr ? 1 : 0;
+int ViewportGizmoController::get_selected_count() const {
+	return selection.size();
 }
 
 bool ViewportGizmoController::is_gizmo_visible() {
 	return gizmo.visible;
 }
 
-Vector3 ViewportGizmoController::_get_ray_pos(const Vector2& p_screenpos) {
-	return cast_to<Camera>(controller->get("camera"))->project_ray_origin(p_screenpos / static_cast<float>(controller->call("get_stretch_shrink")));
+Vector2 ViewportGizmoController::_get_viewport_pos(const Vector2& p_screenpos) {
+	return p_screenpos / static_cast<float>(stretch_shrink);
 }
 
-Vector3 ViewportGizmoController::_get_ray(const Vector2& p_screenpos) {
-	return cast_to<Camera>(controller->get("camera"))->project_ray_normal(p_screenpos) / static_cast<float>(controller->call ("get_stretch_shrink"));
+Vector3 ViewportGizmoController::_get_ray_pos(const Vector2& p_screenpos) {
+	return camera->project_ray_origin(p_screenpos / static_cast<float>(stretch_shrink));
 }
 
-Transform ViewportGizmoController::get_gizmo_transform() {
-	return controller->get("selected") ? cast_to<Spatial>(controller->get("selected"))->get_transform() : Transform();
+Vector3 ViewportGizmoController::_get_ray(const Vector2& p_screenpos) {
+	return camera->project_ray_normal(p_screenpos) / static_cast<float>(stretch_shrink);
 }
 
 Transform ViewportGizmoController::get_global_gizmo_transform() {
-	return controller->get("selected") ? cast_to<Spatial>(controller->get("selected"))->get_global_transform() : Transform();
+	if (!selected) {
+		return Transform();
+	}
+	Transform xform = selected->get_global_transform();
+	xform.origin = _get_pivot();
+	return xform;
 }
 
 void ViewportGizmoController::_compute_edit(const Vector2& p_screenpos) {
 	_edit.click_ray = _get_ray(p_screenpos);
 	_edit.click_ray_pos = _get_ray_pos(p_screenpos);
 	_edit.plane = TRANSFORM_VIEW;
-	update_transform_gizmo();
-	_edit.center = get_gizmo_transform().origin;
+	_update_transform_gizmo();
+	_edit.center = get_global_gizmo_transform().origin;
+
+	Set<Spatial*> selected_nodes;
+	for (int i = 0; i < selection.size(); i++) {
+		selected_nodes.insert(selection[i]);
+	}
 
-	if (controller->get("selected")) {
-		original_transform = get_global_gizmo_transform();
+	// A node moved along with a selected ancestor would otherwise take the delta twice.
+	transformed_nodes.clear();
+	original_transforms.clear();
+	for (int i = 0; i < selection.size(); i++) {
+		bool carried = false;
+		for (Node* parent = selection[i]->get_parent(); parent && !carried; parent = parent->get_parent()) {
+			Spatial* spatial = cast_to<Spatial>(parent);
+			carried = spatial && selected_nodes.has(spatial);
+		}
+		if (!carried) {
+			transformed_nodes.push_back(selection[i]);
+			original_transforms.push_back(selection[i]->get_global_transform());
+		}
 	}
 }
 
+Vector3 ViewportGizmoController::_get_pivot() {
+	// Global like the deltas applied to the selection, the nodes may have different parents.
+	if (pivot_mode == PIVOT_ACTIVE || selection.size() < 2) {
+		return selected->get_global_transform().origin;
+	}
+
+	Vector3 median;
+	for (int i = 0; i < selection.size(); i++) {
+		median += selection[i]->get_global_transform().origin;
+	}
+	return median / selection.size();
+}
+
+void ViewportGizmoController::_apply_selection_transform(const Transform& p_delta) {
+	ERR_FAIL_COND(original_transforms.size() != transformed_nodes.size());
+
+	// One pass over the whole selection. Gizmos are only flagged here and redrawn together once, deferred.
+	for (int i = 0; i < transformed_nodes.size(); i++) {
+		transformed_nodes[i]->set_global_transform(p_delta * original_transforms[i]);
+	}
+	for (int i = 0; i < selection.size(); i++) {
+		update_gizmo(selection[i]);
+	}
+	_update_transform_gizmo();
+}
+
+void ViewportGizmoController::_restore_selection_transforms() {
+	_apply_selection_transform(Transform());
+}
+
+void ViewportGizmoController::_queue_transform_changed() {
+	if (transform_changed_queued) {
+		return;
+	}
+	transform_changed_queued = true;
+	call_deferred("_emit_transform_changed");
+}
+
+void ViewportGizmoController::_emit_transform_changed() {
+	transform_changed_queued = false;
+	self_emitted = true;
+	emit_signal("transform_changed");
+	self_emitted = false;
+}
+
 Vector3 ViewportGizmoController::_get_camera_normal() {
-	return -cast_to<Camera>(controller->get("camera"))->get_camera_transform().basis.get_axis(2);
+	return -camera->get_camera_transform().basis.get_axis(2);
 }
 
 void ViewportGizmoController::select_gizmo_highlight_axis(int axis) {
@@ -961,46 +1323,140 @@ void ViewportGizmoController::select_gizmo_highlight_axis(int axis) {
 void ViewportGizmoController::remove_gizmos_for(const Object* p_node) {
 	Spatial* spatial = const_cast<Spatial*>(cast_to<Spatial>(p_node));
 	if (spatial && gizmos_by_node.has(spatial)) {
+		GizmoInfo& gi = gizmos_by_node[spatial];
+		if (gi.pick_leaf != -1) {
+			pick_tree.remove(gi.pick_leaf);
+		}
+		if (gi.gizmo.is_valid() && gi.gizmo->is_connected("transformed", this, "_gizmo_transformed")) {
+			gi.gizmo->disconnect("transformed", this, "_gizmo_transformed");
+		}
 		gizmos_by_node.erase(spatial);
 	}
+	pick_dirty.erase(spatial);
+
+	int idx = selection.find(spatial);
+	if (idx != -1) {
+		selection.remove(idx);
+	}
+
+	idx = transformed_nodes.find(spatial);
+	if (idx != -1) {
+		transformed_nodes.remove(idx);
+		original_transforms.remove(idx);
+	}
+
+	// The controller would otherwise hand the removed node back on the next refresh.
+	if (spatial && spatial == selected) {
+		selected = selection.empty() ? nullptr : selection[selection.size() - 1];
+		over_gizmo_handle = -1;
+		if (controller) {
+			controller->set(selected_property, selected);
+			_update_transform_gizmo();
+		}
+	}
+}
+
+void ViewportGizmoController::_set_gizmo_selected(Spatial* p_spatial, bool p_selected) {
+	if (!gizmos_by_node.has(p_spatial) && p_selected) {
+		_request_gizmo(p_spatial);
+	}
+	if (!gizmos_by_node.has(p_spatial)) {
+		return;
+	}
+
+	Ref<PahdoSpatialGizmo> spg = gizmos_by_node[p_spatial].gizmo;
+	if (spg.is_valid()) {
+		spg->set_selected(p_selected);
+		update_gizmo(p_spatial);
+	}
+}
+
+void ViewportGizmoController::_set_selection(Spatial* p_active) {
+	for (int i = 0; i < selection.size(); i++) {
+		if (selection[i] != p_active) {
+			_set_gizmo_selected(selection[i], false);
+		}
+	}
+
+	selection.clear();
+	if (p_active) {
+		selection.push_back(p_active);
+		_set_gizmo_selected(p_active, true);
+	}
 }
 
 void ViewportGizmoController::edit(const Object* p_node) {
 	Spatial* spatial = const_cast<Spatial*>(cast_to<Spatial>(p_node));
-	if (spatial != controller->get("selected")) {
-		if (controller->get("selected")) {
-			Ref<PahdoSpatialGizmo> spg;
-			Spatial* selected = cast_to<Spatial>(controller->get("selected"));
-			if (gizmos_by_node.has(selected)) {
-				spg = gizmos_by_node[selected].gizmo;
-			}
-			if (spg.is_valid()) {
-				spg->set_selected(false);
-				update_gizmo(selected);
-			}
-		}
-		controller->set("selected", spatial);
+	_refresh_controller_state();
+	if (spatial != selected || selection.size() > 1) {
+		controller->set(selected_property, spatial);
+		selected = spatial;
 		over_gizmo_handle = -1;
 
-		if (controller->get("selected")) {
-			Ref<PahdoSpatialGizmo> spg;
-			Spatial* selected = cast_to<Spatial>(controller->get("selected"));
-			if (gizmos_by_node.has(selected)) {
-				spg = gizmos_by_node[selected].gizmo;
-			}
-			if (!spg.is_valid()) {
-				_request_gizmo(selected);
-				spg = gizmos_by_node[selected].gizmo;
-			}
-			if (spg.is_valid()) {
-				spg->set_selected(true);
-				update_gizmo(selected);
-			}
-		}
-		update_transform_gizmo();
+		_set_selection(spatial);
+		_update_transform_gizmo();
 	}
 }
 
+void ViewportGizmoController::add_to_selection(const Object* p_node) {
+	Spatial* spatial = const_cast<Spatial*>(cast_to<Spatial>(p_node));
+	ERR_FAIL_NULL(spatial);
+
+	_refresh_controller_state();
+	if (selection.find(spatial) == -1) {
+		selection.push_back(spatial);
+		_set_gizmo_selected(spatial, true);
+	}
+
+	controller->set(selected_property, spatial);
+	selected = spatial;
+	over_gizmo_handle = -1;
+	_update_transform_gizmo();
+}
+
+void ViewportGizmoController::remove_from_selection(const Object* p_node) {
+	Spatial* spatial = const_cast<Spatial*>(cast_to<Spatial>(p_node));
+	_refresh_controller_state();
+
+	int idx = selection.find(spatial);
+	if (idx == -1) {
+		return;
+	}
+	selection.remove(idx);
+	_set_gizmo_selected(spatial, false);
+
+	if (spatial == selected) {
+		selected = selection.empty() ? nullptr : selection[selection.size() - 1];
+		controller->set(selected_property, selected);
+		over_gizmo_handle = -1;
+	}
+	_update_transform_gizmo();
+}
+
+void ViewportGizmoController::clear_selection() {
+	edit(nullptr);
+}
+
+Array ViewportGizmoController::get_selection() const {
+	Array nodes;
+	for (int i = 0; i < selection.size(); i++) {
+		nodes.push_back(selection[i]);
+	}
+	return nodes;
+}
+
+void ViewportGizmoController::set_pivot_mode(int p_mode) {
+	ERR_FAIL_INDEX(p_mode, PIVOT_ACTIVE + 1);
+	pivot_mode = p_mode;
+	if (controller && selected) {
+		_update_transform_gizmo();
+	}
+}
+
+int ViewportGizmoController::get_pivot_mode() const {
+	return pivot_mode;
+}
+
 void ViewportGizmoController::_bind_methods() {
 	BIND_VMETHOD(MethodInfo("register_all_gizmos"));
 
@@ -1008,21 +1464,53 @@ void ViewportGizmoController::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("gui_input", "event"), &ViewportGizmoController::gui_input);
 	ClassDB::bind_method(D_METHOD("update_all_gizmos", "spatial"), &ViewportGizmoController::update_all_gizmos);
 	ClassDB::bind_method("update_transform_gizmo", &ViewportGizmoController::update_transform_gizmo);
+	ClassDB::bind_method("refresh_controller_state", &ViewportGizmoController::refresh_controller_state);
 	ClassDB::bind_method(D_METHOD("edit", "spatial"), &ViewportGizmoController::edit);
+	ClassDB::bind_method(D_METHOD("add_to_selection", "spatial"), &ViewportGizmoController::add_to_selection);
+	ClassDB::bind_method(D_METHOD("remove_from_selection", "spatial"), &ViewportGizmoController::remove_from_selection);
+	ClassDB::bind_method("clear_selection", &ViewportGizmoController::clear_selection);
+	ClassDB::bind_method("get_selection", &ViewportGizmoController::get_selection);
+	ClassDB::bind_method("get_selected_count", &ViewportGizmoController::get_selected_count);
+	ClassDB::bind_method(D_METHOD("set_pivot_mode", "mode"), &ViewportGizmoController::set_pivot_mode);
+	ClassDB::bind_method("get_pivot_mode", &ViewportGizmoController::get_pivot_mode);
 	ClassDB::bind_method(D_METHOD("remove_gizmos_for", "spatial"), &ViewportGizmoController::remove_gizmos_for);
+	ClassDB::bind_method(D_METHOD("pick_gizmo", "point"), &ViewportGizmoController::pick_gizmo);
+	ClassDB::bind_method(D_METHOD("box_select", "rect", "add"), &ViewportGizmoController::box_select, DEFVAL(false));
 	ClassDB::bind_method(D_METHOD("set_viewport_controller", "controller"), &ViewportGizmoController::set_viewport_controller);
 	ClassDB::bind_method("_on_other_transform_changed", &ViewportGizmoController::_on_other_transform_changed);
 
 	ClassDB::bind_method(D_METHOD("_update_gizmo", "spatial"), &ViewportGizmoController::_update_gizmo);
+	ClassDB::bind_method("_emit_transform_changed", &ViewportGizmoController::_emit_transform_changed);
+	ClassDB::bind_method(D_METHOD("_gizmo_transformed", "spatial"), &ViewportGizmoController::_gizmo_transformed);
+	ClassDB::bind_method("_box_selection_draw", &ViewportGizmoController::_box_selection_draw);
+
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "pivot_mode", PROPERTY_HINT_ENUM, "Median,Active"), "set_pivot_mode", "get_pivot_mode");
 
 	ADD_SIGNAL(MethodInfo("transform_changed"));
 }
 
 ViewportGizmoController::ViewportGizmoController() {
+	controller = nullptr;
+	selected_property = "selected";
+	camera_property = "camera";
+	current_mode_property = "current_mode";
+	get_stretch_shrink_method = "get_stretch_shrink";
+	selected = nullptr;
+	camera = nullptr;
+	current_mode = NONE_MODE;
+	stretch_shrink = 1;
+	pivot_mode = PIVOT_MEDIAN;
+	transform_changed_queued = false;
+	box_selection = nullptr;
+	box_selecting = false;
 	connect(TTR("transform_changed"), this, "_on_other_transform_changed");
 }
 
 ViewportGizmoController::~ViewportGizmoController() {
 	_finish_indicators();
 	_finish_gizmo_instances();
+
+	if (box_selection && ObjectDB::instance_validate(box_selection)) {
+		box_selection->queue_delete();
+	}
 }
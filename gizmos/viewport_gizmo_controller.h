@@ -1,7 +1,11 @@
 #ifndef VIEWPORT_GIZMO_CONTROLLER_H
 #define VIEWPORT_GIZMO_CONTROLLER_H
+#include "gizmo_aabb_tree.h"
 #include "pahdo_spatial_gizmo.h"
 #include "core/reference.h"
+#include "core/set.h"
+
+class Camera;
 
 class ViewportGizmoController : public Reference {
 	GDCLASS(ViewportGizmoController, Reference);
@@ -14,6 +18,8 @@ class ViewportGizmoController : public Reference {
 	const float GIZMO_RING_HALF_WIDTH = 0.1;
 	const float GIZMO_PLANE_SIZE = 0.2;
 	const float GIZMO_PLANE_DST = 0.3;
+	// Pixels around the cursor that still pick a gizmo, the widest of the tolerances intersect_ray uses.
+	const float GIZMO_PICK_MARGIN = 10.0;
 
 	enum {
 		NONE_MODE = 0,
@@ -22,6 +28,11 @@ class ViewportGizmoController : public Reference {
 		ROTATE_MODE = 4
 	};
 
+	enum PivotMode {
+		PIVOT_MEDIAN,
+		PIVOT_ACTIVE,
+	};
+
 	enum TransformType {
 		TRANSFORM_NONE,
 		TRANSFORM_ROTATE,
@@ -63,7 +74,25 @@ class ViewportGizmoController : public Reference {
 
 	Control* controller;
 
-	Transform original_transform;
+	// The controller's state, read once per call from the controller instead of looking the
+	// properties up by name everywhere they are used.
+	StringName selected_property;
+	StringName camera_property;
+	StringName current_mode_property;
+	StringName get_stretch_shrink_method;
+	Spatial* selected;
+	Camera* camera;
+	int current_mode;
+	int stretch_shrink;
+
+	// Every selected node, the active one is the controller's "selected" and always part of it.
+	Vector<Spatial*> selection;
+	// Nodes the current edit moves, the selection without the nodes a selected ancestor already carries,
+	// and their global transforms when the edit started, in the same order.
+	Vector<Spatial*> transformed_nodes;
+	Vector<Transform> original_transforms;
+	int pivot_mode;
+	bool transform_changed_queued;
 
 	RID origin;
 	RID origin_instance;
@@ -87,10 +116,38 @@ class ViewportGizmoController : public Reference {
 	struct GizmoInfo {
 		bool gizmo_dirty;
 		Ref<PahdoSpatialGizmo> gizmo;
+		int pick_leaf = -1; // Leaf in pick_tree, -1 while the gizmo has nothing to hit.
 	};
 
 	Map<Spatial*, GizmoInfo> gizmos_by_node;
 
+	// Bounds of every registered gizmo, so picking tests the gizmos near the mouse ray instead of all of them.
+	// Gizmos that moved or were redrawn are refitted right before the next pick.
+	GizmoAABBTree pick_tree;
+	Set<Spatial*> pick_dirty;
+
+	// A box select tests this many gizmos or more on worker threads.
+	const int BOX_SELECT_THREADED_MIN = 64;
+
+	struct BoxSelectCandidate {
+		Spatial* spatial;
+		const PahdoSpatialGizmo* gizmo;
+		Transform global;
+		bool hit;
+	};
+
+	// What the workers of a box select read, everything they need is gathered beforehand on the main thread.
+	struct BoxSelectData {
+		Vector<Plane> frustum;
+		Vector<Vector3> convex_points;
+		BoxSelectCandidate* candidates;
+	};
+
+	Control* box_selection;
+	bool box_selecting;
+	Vector2 box_selecting_from;
+	Rect2 box_select_rect;
+
 private:
 	void _init_origin();
 	void _init_translate(const Vector3& nivec, const Vector3& ivec, const Ref<SpatialMaterial>& p_mat, int idx);
@@ -101,11 +158,18 @@ private:
 	void select_gizmo_highlight_axis(int axis);
 	void _finish_indicators();
 	void _finish_gizmo_instances();
-	int get_selected_count();
+	void _set_gizmo_selected(Spatial* p_spatial, bool p_selected);
+	void _set_selection(Spatial* p_active);
+	Vector3 _get_pivot();
+	void _apply_selection_transform(const Transform& p_delta);
+	void _restore_selection_transforms();
+	void _queue_transform_changed();
+	void _emit_transform_changed();
 	bool is_gizmo_visible();
+	// Events come in the controller's pixels, the camera's viewport is stretch_shrink times smaller.
+	Vector2 _get_viewport_pos(const Vector2& p_screenpos);
 	Vector3 _get_ray_pos(const Vector2& p_screenpos);
 	Vector3 _get_ray(const Vector2& p_screenpos);
-	Transform get_gizmo_transform();
 	Transform get_global_gizmo_transform();
 	void _compute_edit(const Vector2& p_screenpos);
 	Vector3 _get_camera_normal();
@@ -113,7 +177,16 @@ private:
 	void _request_gizmo(Spatial* p_spatial);
 	void update_gizmo(Spatial* p_spatial);
 	void _update_all_gizmos(const Object* p_node);
+	void _refit_pick_tree();
+	Spatial* _pick_gizmo(const Vector2& p_screenpos);
+	Vector<Plane> _get_frustum(const Rect2& p_rect);
+	void _box_select_candidate(uint32_t p_index, BoxSelectData* p_data);
+	void _box_select(const Rect2& p_rect, bool p_add);
+	void _box_selection_draw();
+	void _gizmo_transformed(Object* p_spatial);
+	void _update_transform_gizmo();
 	void update_transform_gizmo_view();
+	void _refresh_controller_state();
 
 protected:
 	static void _bind_methods();
@@ -123,11 +196,29 @@ public:
 
 	void update_all_gizmos(const Object* p_node = nullptr);
 	void update_transform_gizmo();
+	// Called by the controller when its camera, selection or mode changes outside of the calls below.
+	void refresh_controller_state();
 	void gui_input(Ref<InputEvent> p_event);
 	void set_viewport_controller(const Object* p_controller);
 	void add_gizmo_plugin(const Ref<PahdoSpatialGizmoPlugin> p_plugin);
 	void remove_gizmos_for(const Object* p_node);
+	// Node of the nearest gizmo under p_point, in viewport coordinates, or null.
+	Object* pick_gizmo(const Vector2& p_point);
+	// Selects the nodes whose gizmos are entirely inside p_rect, in viewport coordinates, or adds them to the selection.
+	void box_select(const Rect2& p_rect, bool p_add = false);
 	void edit(const Object* p_node);
+
+	// edit() replaces the selection, these grow and shrink it. The last node added becomes the active one.
+	void add_to_selection(const Object* p_node);
+	void remove_from_selection(const Object* p_node);
+	void clear_selection();
+	Array get_selection() const;
+	int get_selected_count() const;
+
+	// Where the transform gizmo sits when several nodes are selected, at their median or on the active one.
+	void set_pivot_mode(int p_mode);
+	int get_pivot_mode() const;
+
 	void _on_other_transform_changed();
 
 	ViewportGizmoController();
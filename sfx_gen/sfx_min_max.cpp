@@ -0,0 +1,165 @@
+#include "sfx_min_max.h"
+
+#include "core/error_macros.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SFX_MIN_MAX_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+// AVX is compiled per function, the module is not built with it enabled.
+#define SFX_MIN_MAX_AVX
+#include <immintrin.h>
+#endif
+#endif
+
+// Frames are reduced as a flat array of floats, left and right channels alike.
+static_assert(sizeof(AudioFrame) == sizeof(float) * 2, "AudioFrame must be two packed floats.");
+
+typedef void (*MinMaxFunc)(const float* p_src, int p_count, float& r_min, float& r_max);
+
+static void _min_max_scalar(const float* p_src, int p_count, float& r_min, float& r_max) {
+	float min = r_min;
+	float max = r_max;
+	for (int i = 0; i < p_count; i++) {
+		min = MIN(min, p_src[i]);
+		max = MAX(max, p_src[i]);
+	}
+	r_min = min;
+	r_max = max;
+}
+
+#ifdef SFX_MIN_MAX_SSE2
+static void _min_max_sse2(const float* p_src, int p_count, float& r_min, float& r_max) {
+	__m128 vmin = _mm_set1_ps(r_min);
+	__m128 vmax = _mm_set1_ps(r_max);
+
+	int i = 0;
+	for (; i + 4 <= p_count; i += 4) {
+		__m128 v = _mm_loadu_ps(p_src + i);
+		vmin = _mm_min_ps(vmin, v);
+		vmax = _mm_max_ps(vmax, v);
+	}
+
+	float mins[4];
+	float maxs[4];
+	_mm_storeu_ps(mins, vmin);
+	_mm_storeu_ps(maxs, vmax);
+	for (int j = 0; j < 4; j++) {
+		r_min = MIN(r_min, mins[j]);
+		r_max = MAX(r_max, maxs[j]);
+	}
+
+	_min_max_scalar(p_src + i, p_count - i, r_min, r_max);
+}
+#endif
+
+#ifdef SFX_MIN_MAX_AVX
+__attribute__((target("avx"))) static void _min_max_avx(const float* p_src, int p_count, float& r_min, float& r_max) {
+	__m256 vmin = _mm256_set1_ps(r_min);
+	__m256 vmax = _mm256_set1_ps(r_max);
+
+	// Two accumulators per bound keep the min/max latency off the critical path.
+	__m256 vmin2 = vmin;
+	__m256 vmax2 = vmax;
+
+	int i = 0;
+	for (; i + 16 <= p_count; i += 16) {
+		__m256 a = _mm256_loadu_ps(p_src + i);
+		__m256 b = _mm256_loadu_ps(p_src + i + 8);
+		vmin = _mm256_min_ps(vmin, a);
+		vmax = _mm256_max_ps(vmax, a);
+		vmin2 = _mm256_min_ps(vmin2, b);
+		vmax2 = _mm256_max_ps(vmax2, b);
+	}
+	vmin = _mm256_min_ps(vmin, vmin2);
+	vmax = _mm256_max_ps(vmax, vmax2);
+
+	float mins[8];
+	float maxs[8];
+	_mm256_storeu_ps(mins, vmin);
+	_mm256_storeu_ps(maxs, vmax);
+	for (int j = 0; j < 8; j++) {
+		r_min = MIN(r_min, mins[j]);
+		r_max = MAX(r_max, maxs[j]);
+	}
+
+	_min_max_sse2(p_src + i, p_count - i, r_min, r_max);
+}
+#endif
+
+static MinMaxFunc _select_min_max() {
+#ifdef SFX_MIN_MAX_AVX
+	if (__builtin_cpu_supports("avx")) {
+		return _min_max_avx;
+	}
+#endif
+#ifdef SFX_MIN_MAX_SSE2
+	// Always there on x86_64.
+	return _min_max_sse2;
+#else
+	return _min_max_scalar;
+#endif
+}
+
+#ifdef DEBUG_ENABLED
+bool sfx_min_max_has_kernel(SFXMinMaxKernel p_kernel) {
+	switch (p_kernel) {
+	case SFX_MIN_MAX_KERNEL_SCALAR:
+		return true;
+#ifdef SFX_MIN_MAX_SSE2
+	case SFX_MIN_MAX_KERNEL_SSE2:
+		return true;
+#endif
+#ifdef SFX_MIN_MAX_AVX
+	case SFX_MIN_MAX_KERNEL_AVX:
+		return __builtin_cpu_supports("avx");
+#endif
+	default:
+		return false;
+	}
+}
+
+void sfx_min_max_run_kernel(SFXMinMaxKernel p_kernel, const float* p_src, int p_count, float& r_min, float& r_max) {
+	ERR_FAIL_COND(!sfx_min_max_has_kernel(p_kernel));
+
+	switch (p_kernel) {
+#ifdef SFX_MIN_MAX_SSE2
+	case SFX_MIN_MAX_KERNEL_SSE2:
+		_min_max_sse2(p_src, p_count, r_min, r_max);
+		break;
+#endif
+#ifdef SFX_MIN_MAX_AVX
+	case SFX_MIN_MAX_KERNEL_AVX:
+		_min_max_avx(p_src, p_count, r_min, r_max);
+		break;
+#endif
+	default:
+		_min_max_scalar(p_src, p_count, r_min, r_max);
+		break;
+	}
+}
+#endif
+
+void sfx_reduce_min_max(const AudioFrame* p_frames, int p_frame_count, int p_buckets, uint8_t* r_min_max) {
+	ERR_FAIL_COND(p_frame_count <= 0 && p_buckets > 0);
+
+	static const MinMaxFunc min_max = _select_min_max();
+	const float* samples = reinterpret_cast<const float*>(p_frames);
+
+	for (int i = 0; i < p_buckets; i++) {
+		int from = uint64_t(i) * p_frame_count / p_buckets;
+		int to = (uint64_t(i) + 1) * p_frame_count / p_buckets;
+		to = MIN(to, p_frame_count);
+		from = MIN(from, p_frame_count - 1);
+		if (to == from) {
+			to = from + 1;
+		}
+
+		float min = 1000;
+		float max = -1000;
+		min_max(samples + from * 2, (to - from) * 2, min, max);
+
+		r_min_max[i * 2 + 0] = CLAMP((min * 0.5 + 0.5) * 255, 0, 255);
+		r_min_max[i * 2 + 1] = CLAMP((max * 0.5 + 0.5) * 255, 0, 255);
+	}
+}
@@ -0,0 +1,26 @@
+#ifndef SFX_MIN_MAX_H
+#define SFX_MIN_MAX_H
+
+#include "core/math/audio_frame.h"
+
+// Splits p_frame_count frames into p_buckets equal buckets and writes the min and max of
+// both channels of each one to r_min_max, quantized to a byte pair like SFXPreview entries.
+// Uses SSE2 or AVX when the CPU has them, the result is the same as the scalar path.
+void sfx_reduce_min_max(const AudioFrame* p_frames, int p_frame_count, int p_buckets, uint8_t* r_min_max);
+
+#ifdef DEBUG_ENABLED
+// The kernels sfx_reduce_min_max picks from, so tests can run each one, not only the one this CPU gets.
+enum SFXMinMaxKernel {
+	SFX_MIN_MAX_KERNEL_SCALAR,
+	SFX_MIN_MAX_KERNEL_SSE2,
+	SFX_MIN_MAX_KERNEL_AVX,
+	SFX_MIN_MAX_KERNEL_MAX
+};
+
+// False when the kernel isn't built for this platform or the CPU lacks the instructions.
+bool sfx_min_max_has_kernel(SFXMinMaxKernel p_kernel);
+// Widens r_min and r_max to cover the p_count floats at p_src.
+void sfx_min_max_run_kernel(SFXMinMaxKernel p_kernel, const float* p_src, int p_count, float& r_min, float& r_max);
+#endif
+
+#endif
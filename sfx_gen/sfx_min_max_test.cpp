@@ -0,0 +1,163 @@
+#include "sfx_min_max_test.h"
+
+#ifdef DEBUG_ENABLED
+
+#include "core/math/random_pcg.h"
+#include "core/print_string.h"
+#include "core/vector.h"
+#include "sfx_min_max.h"
+
+static const char* _kernel_name(SFXMinMaxKernel p_kernel) {
+	switch (p_kernel) {
+	case SFX_MIN_MAX_KERNEL_SCALAR:
+		return "scalar";
+	case SFX_MIN_MAX_KERNEL_SSE2:
+		return "sse2";
+	case SFX_MIN_MAX_KERNEL_AVX:
+		return "avx";
+	default:
+		return "unknown";
+	}
+}
+
+static void _fill_random(RandomPCG& p_rng, float* p_dst, int p_count) {
+	for (int i = 0; i < p_count; i++) {
+		p_dst[i] = p_rng.random(-1.0f, 1.0f);
+	}
+}
+
+static bool _test_kernel(SFXMinMaxKernel p_kernel) {
+	RandomPCG rng(0x5f3759df);
+
+	// Every length up to a few AVX widths, so each main loop and tail combination runs,
+	// read one float in so the loads are unaligned.
+	float buffer[70];
+	for (int count = 0; count < 67; count++) {
+		for (int pass = 0; pass < 4; pass++) {
+			_fill_random(rng, buffer, 70);
+			if (pass == 1 && count > 0) {
+				// The extremes last, where only the tail loop sees them.
+				buffer[count] = -1.0;
+				buffer[1] = 1.0;
+			}
+			else if (pass == 2) {
+				// Flat buffers, min and max equal.
+				for (int i = 0; i < 70; i++) {
+					buffer[i] = 0.25;
+				}
+			}
+			else if (pass == 3) {
+				// Out of range values are reported as they are, clamping is up to the caller.
+				for (int i = 0; i < 70; i++) {
+					buffer[i] *= 4.0;
+				}
+			}
+
+			float expected_min = 1000;
+			float expected_max = -1000;
+			for (int i = 0; i < count; i++) {
+				expected_min = MIN(expected_min, buffer[i + 1]);
+				expected_max = MAX(expected_max, buffer[i + 1]);
+			}
+
+			float min = 1000;
+			float max = -1000;
+			sfx_min_max_run_kernel(p_kernel, buffer + 1, count, min, max);
+			if (min != expected_min || max != expected_max) {
+				print_error(vformat("sfx_min_max: %s kernel got [%f, %f] instead of [%f, %f] on %d samples.", _kernel_name(p_kernel), min, max, expected_min, expected_max, count));
+				return false;
+			}
+		}
+	}
+
+	// Starting bounds already past every sample come back untouched.
+	_fill_random(rng, buffer, 70);
+	float min = -2;
+	float max = 2;
+	sfx_min_max_run_kernel(p_kernel, buffer, 70, min, max);
+	if (min != -2 || max != 2) {
+		print_error(vformat("sfx_min_max: %s kernel narrowed the bounds it was given.", _kernel_name(p_kernel)));
+		return false;
+	}
+
+	return true;
+}
+
+static uint8_t _quantize(float p_value) {
+	double v = (p_value * 0.5 + 0.5) * 255;
+	return v <= 0 ? 0 : (v >= 255 ? 255 : uint8_t(v));
+}
+
+// Bucket i spans frames [i * count / buckets, (i + 1) * count / buckets), at least one frame
+// and never past the last one, so more buckets than frames repeat frames instead of reading past them.
+static void _reduce_reference(const Vector<AudioFrame>& p_frames, int p_buckets, uint8_t* r_min_max) {
+	int count = p_frames.size();
+	for (int i = 0; i < p_buckets; i++) {
+		int from = MIN(int(int64_t(i) * count / p_buckets), count - 1);
+		int to = MAX(from + 1, MIN(int((int64_t(i) + 1) * count / p_buckets), count));
+
+		float min = 1000;
+		float max = -1000;
+		for (int j = from; j < to; j++) {
+			min = MIN(min, MIN(p_frames[j].l, p_frames[j].r));
+			max = MAX(max, MAX(p_frames[j].l, p_frames[j].r));
+		}
+		r_min_max[i * 2 + 0] = _quantize(min);
+		r_min_max[i * 2 + 1] = _quantize(max);
+	}
+}
+
+static bool _test_reduce() {
+	RandomPCG rng(0x9e3779b9);
+
+	static const int frame_counts[] = { 1, 2, 7, 64, 1000, 11025 };
+	static const int bucket_counts[] = { 1, 2, 3, 7, 64, 500, 2756 };
+
+	for (int fc = 0; fc < int(sizeof(frame_counts) / sizeof(frame_counts[0])); fc++) {
+		int frame_count = frame_counts[fc];
+		Vector<AudioFrame> frames;
+		frames.resize(frame_count);
+		for (int i = 0; i < frame_count; i++) {
+			// A little past full scale, so the quantization clamps on both ends too.
+			frames.write[i] = AudioFrame(rng.random(-1.1f, 1.1f), rng.random(-1.1f, 1.1f));
+		}
+
+		for (int bc = 0; bc < int(sizeof(bucket_counts) / sizeof(bucket_counts[0])); bc++) {
+			int buckets = bucket_counts[bc];
+			Vector<uint8_t> expected;
+			expected.resize(buckets * 2);
+			_reduce_reference(frames, buckets, expected.ptrw());
+
+			Vector<uint8_t> result;
+			result.resize(buckets * 2);
+			sfx_reduce_min_max(frames.ptr(), frame_count, buckets, result.ptrw());
+
+			for (int i = 0; i < buckets * 2; i++) {
+				if (result[i] != expected[i]) {
+					print_error(vformat("sfx_min_max: sfx_reduce_min_max got %d instead of %d at bucket %d of %d over %d frames.", result[i], expected[i], i / 2, buckets, frame_count));
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+bool sfx_min_max_run_tests() {
+	bool passed = true;
+	for (int i = 0; i < SFX_MIN_MAX_KERNEL_MAX; i++) {
+		SFXMinMaxKernel kernel = SFXMinMaxKernel(i);
+		if (!sfx_min_max_has_kernel(kernel)) {
+			print_line(vformat("sfx_min_max: %s kernel not available, skipped.", _kernel_name(kernel)));
+			continue;
+		}
+		passed = _test_kernel(kernel) && passed;
+	}
+	passed = _test_reduce() && passed;
+
+	print_line(passed ? "sfx_min_max: all tests passed." : "sfx_min_max: tests failed.");
+	return passed;
+}
+
+#endif
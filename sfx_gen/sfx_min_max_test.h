@@ -0,0 +1,11 @@
+#ifndef SFX_MIN_MAX_TEST_H
+#define SFX_MIN_MAX_TEST_H
+
+#ifdef DEBUG_ENABLED
+// Checks every min/max kernel the CPU can run against a plain loop, then sfx_reduce_min_max against
+// a scalar reference of its bucketing and quantization. Failures are printed, returns true when all pass.
+// Bound as SFXPreviewGenerator.run_min_max_tests(), e.g. run from a script with godot -s.
+bool sfx_min_max_run_tests();
+#endif
+
+#endif
@@ -1,14 +1,57 @@
 #include "sfx_preview.h"
 
-float SFXPreview::get_length() const {
-	return length;
+void SFXPreview::_build_mips() {
+	mips.clear();
+	int count = preview.size() / 2;
+	while (count > 1) {
+		count = (count + 1) / 2;
+		Vector<uint8_t> level;
+		level.resize(count * 2);
+		mips.push_back(level);
+	}
+	_update_mips(0, preview.size() / 2);
 }
 
-float SFXPreview::get_max(float p_time, float p_time_next) const {
-	if (length == 0) {
-		return 0;
+void SFXPreview::_resize(int p_entries, float p_length, bool p_streaming) {
+	mutex.lock();
+
+	int old_entries = preview.size() / 2;
+	preview.resize(p_entries * 2);
+	uint8_t* ptr = preview.ptrw();
+	for (int i = old_entries * 2; i < p_entries * 2; i++) {
+		ptr[i] = 127;
+	}
+
+	length = p_length;
+	streaming = p_streaming;
+	_build_mips();
+	if (int(written.get()) > p_entries) {
+		written.set(p_entries);
+	}
+
+	mutex.unlock();
+}
+
+void SFXPreview::_update_mips(int p_from, int p_to) {
+	int from = p_from;
+	int to = p_to;
+	for (int k = 0; k < mips.size(); k++) {
+		const uint8_t* src = _get_level(k).ptr();
+		int src_count = _get_level(k).size() / 2;
+		uint8_t* dst = mips.write[k].ptrw();
+
+		from = from / 2;
+		to = (to + 1) / 2;
+		for (int i = from; i < to; i++) {
+			int a = i * 2;
+			int b = MIN(a + 1, src_count - 1);
+			dst[i * 2 + 0] = MIN(src[a * 2 + 0], src[b * 2 + 0]);
+			dst[i * 2 + 1] = MAX(src[a * 2 + 1], src[b * 2 + 1]);
+		}
 	}
+}
 
+void SFXPreview::_get_min_max(float p_time, float p_time_next, uint8_t& r_min, uint8_t& r_max) const {
 	int max = preview.size() / 2;
 	int time_from = p_time / length * max;
 	int time_to = p_time_next / length * max;
@@ -19,49 +62,196 @@ float SFXPreview::get_max(float p_time, float p_time_next) const {
 		time_to = time_from + 1;
 	}
 
-	uint8_t vmax = 0;
+	time_to = MIN(time_to, int(written.get()));
+	if (time_to <= time_from) {
+		r_min = 127;
+		r_max = 127;
+		return;
+	}
+
+	r_min = 255;
+	r_max = 0;
+
+	// Walk up the pyramid, taking the odd entries at both ends of the range from each level,
+	// so a range of any length reads O(log n) entries.
+	int from = time_from;
+	int to = time_to;
+	for (int k = 0; from < to; k++) {
+		const uint8_t* level = _get_level(k).ptr();
+		if (from & 1) {
+			r_min = MIN(r_min, level[from * 2 + 0]);
+			r_max = MAX(r_max, level[from * 2 + 1]);
+			from++;
+		}
+		if (to & 1) {
+			to--;
+			r_min = MIN(r_min, level[to * 2 + 0]);
+			r_max = MAX(r_max, level[to * 2 + 1]);
+		}
+		from /= 2;
+		to /= 2;
+	}
+}
 
-	for (int i = time_from; i < time_to; i++) {
-		uint8_t v = preview[i * 2 + 1];
-		if (i == 0 || v > vmax) {
-			vmax = v;
+void SFXPreview::_fill_waveform_lines(float p_from, float p_to, const Rect2& p_rect, int p_columns, Vector2* r_lines) const {
+	bool empty = length == 0 || preview.size() == 0;
+	float step = (p_to - p_from) / p_columns;
+	for (int i = 0; i < p_columns; i++) {
+		uint8_t vmin = 127;
+		uint8_t vmax = 127;
+		if (!empty) {
+			_get_min_max(p_from + i * step, p_from + (i + 1) * step, vmin, vmax);
 		}
+
+		float x = p_rect.position.x + i;
+		r_lines[i * 2 + 0] = Vector2(x, p_rect.position.y + (vmin / 255.0) * p_rect.size.y);
+		r_lines[i * 2 + 1] = Vector2(x, p_rect.position.y + (vmax / 255.0) * p_rect.size.y);
+	}
+}
+
+float SFXPreview::get_length() const {
+	mutex.lock();
+	float result = length;
+	if (streaming && preview.size() > 0) {
+		result = length * written.get() / (preview.size() / 2);
+	}
+	mutex.unlock();
+	return result;
+}
+
+float SFXPreview::get_max(float p_time, float p_time_next) const {
+	mutex.lock();
+	if (length == 0 || preview.size() == 0) {
+		mutex.unlock();
+		return 0;
 	}
 
+	uint8_t vmin, vmax;
+	_get_min_max(p_time, p_time_next, vmin, vmax);
+	mutex.unlock();
 	return (vmax / 255.0) * 2.0 - 1.0;
 }
 
 float SFXPreview::get_min(float p_time, float p_time_next) const {
-	if (length == 0) {
+	mutex.lock();
+	if (length == 0 || preview.size() == 0) {
+		mutex.unlock();
 		return 0;
 	}
 
-	int max = preview.size() / 2;
-	int time_from = p_time / length * max;
-	int time_to = p_time_next / length * max;
-	time_from = CLAMP(time_from, 0, max - 1);
-	time_to = CLAMP(time_to, 0, max - 1);
+	uint8_t vmin, vmax;
+	_get_min_max(p_time, p_time_next, vmin, vmax);
+	mutex.unlock();
+	return (vmin / 255.0) * 2.0 - 1.0;
+}
 
-	if (time_to <= time_from) {
-		time_to = time_from + 1;
+PoolVector2Array SFXPreview::get_min_max_range(float p_from, float p_to, int p_columns) const {
+	PoolVector2Array result;
+	ERR_FAIL_COND_V(p_columns < 0, result);
+	result.resize(p_columns);
+
+	PoolVector2Array::Write w = result.write();
+	mutex.lock();
+	if (length == 0 || preview.size() == 0) {
+		mutex.unlock();
+		for (int i = 0; i < p_columns; i++) {
+			w[i] = Vector2();
+		}
+		return result;
 	}
 
-	uint8_t vmin = 255;
+	float step = (p_to - p_from) / p_columns;
+	for (int i = 0; i < p_columns; i++) {
+		uint8_t vmin, vmax;
+		_get_min_max(p_from + i * step, p_from + (i + 1) * step, vmin, vmax);
+		w[i] = Vector2((vmin / 255.0) * 2.0 - 1.0, (vmax / 255.0) * 2.0 - 1.0);
+	}
+	mutex.unlock();
+	return result;
+}
 
-	for (int i = time_from; i < time_to; i++) {
-		uint8_t v = preview[i * 2];
-		if (i == 0 || v < vmin) {
-			vmin = v;
-		}
+int SFXPreview::get_memory_usage() const {
+	mutex.lock();
+	int usage = preview.size();
+	for (int i = 0; i < mips.size(); i++) {
+		usage += mips[i].size();
 	}
+	mutex.unlock();
+	return usage;
+}
 
-	return (vmin / 255.0) * 2.0 - 1.0;
+int SFXPreview::get_level_count() const {
+	mutex.lock();
+	int count = mips.size() + 1;
+	mutex.unlock();
+	return count;
+}
+
+int SFXPreview::get_level_for(float p_time_span, int p_columns) const {
+	mutex.lock();
+	if (length == 0 || p_columns <= 0) {
+		mutex.unlock();
+		return 0;
+	}
+
+	float entries_per_column = p_time_span / length * (preview.size() / 2) / p_columns;
+	int level = 0;
+	while (level < mips.size() && entries_per_column >= 2) {
+		entries_per_column /= 2;
+		level++;
+	}
+	mutex.unlock();
+	return level;
+}
+
+PoolByteArray SFXPreview::get_level_data(int p_level) const {
+	mutex.lock();
+	int level_count = mips.size() + 1;
+	if (p_level < 0 || p_level >= level_count) {
+		mutex.unlock();
+		ERR_FAIL_INDEX_V(p_level, level_count, PoolByteArray());
+	}
+
+	const Vector<uint8_t>& level = _get_level(p_level);
+	PoolByteArray result;
+	result.resize(level.size());
+	{
+		PoolByteArray::Write w = result.write();
+		memcpy(w.ptr(), level.ptr(), level.size());
+	}
+	mutex.unlock();
+	return result;
+}
+
+void SFXPreview::fill_waveform_lines(float p_from, float p_to, const Rect2& p_rect, Vector<Vector2>& r_lines) const {
+	int columns = MAX(0, int(p_rect.size.x));
+	r_lines.resize(columns * 2);
+	mutex.lock();
+	_fill_waveform_lines(p_from, p_to, p_rect, columns, r_lines.ptrw());
+	mutex.unlock();
+}
+
+PoolVector2Array SFXPreview::get_waveform_lines(float p_from, float p_to, const Rect2& p_rect) const {
+	int columns = MAX(0, int(p_rect.size.x));
+	PoolVector2Array lines;
+	lines.resize(columns * 2);
+	PoolVector2Array::Write w = lines.write();
+	mutex.lock();
+	_fill_waveform_lines(p_from, p_to, p_rect, columns, w.ptr());
+	mutex.unlock();
+	return lines;
 }
 
 void SFXPreview::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_min", "time", "time_next"), &SFXPreview::get_min);
 	ClassDB::bind_method(D_METHOD("get_max", "time", "time_next"), &SFXPreview::get_max);
+	ClassDB::bind_method(D_METHOD("get_min_max_range", "from", "to", "columns"), &SFXPreview::get_min_max_range);
+	ClassDB::bind_method("get_level_count", &SFXPreview::get_level_count);
+	ClassDB::bind_method(D_METHOD("get_level_for", "time_span", "columns"), &SFXPreview::get_level_for);
+	ClassDB::bind_method(D_METHOD("get_level_data", "level"), &SFXPreview::get_level_data);
+	ClassDB::bind_method(D_METHOD("get_waveform_lines", "from", "to", "rect"), &SFXPreview::get_waveform_lines);
 	ClassDB::bind_method("get_length", &SFXPreview::get_length);
+	ClassDB::bind_method("get_memory_usage", &SFXPreview::get_memory_usage);
 
 	ADD_PROPERTY(PropertyInfo(Variant::REAL, "length"), "", "get_length");
 }
@@ -1,22 +1,60 @@
 #ifndef SFX_PREVIEW_H
 #define SFX_PREVIEW_H
 
+#include "core/os/mutex.h"
 #include "core/reference.h"
+#include "core/safe_refcount.h"
 
 class SFXPreview : public Reference {
 	GDCLASS(SFXPreview, Reference);
 
 	friend class _SFXPreviewGenerator;
 	Vector<uint8_t> preview;
+	// Min/max pyramid over preview, every level pairs up two entries of the level below.
+	// mips[0] is half the resolution of preview, the last level holds a single entry.
+	Vector<Vector<uint8_t>> mips;
+	// Entries of preview the generator has filled in, with their mips. Readers treat the rest as silence.
+	SafeNumeric<uint32_t> written;
 	float length;
+	// The stream reported no length, preview grows as it is decoded and length is its capacity so far.
+	bool streaming = false;
+
+	// Held by readers and by the generator while it reallocates a growing preview.
+	// Filling entries below capacity needs no lock, readers stop at written.
+	mutable Mutex mutex;
+
+	const Vector<uint8_t>& _get_level(int p_level) const { return p_level == 0 ? preview : mips[p_level - 1]; }
+	void _build_mips();
+	void _resize(int p_entries, float p_length, bool p_streaming);
+	void _update_mips(int p_from, int p_to);
+	void _get_min_max(float p_time, float p_time_next, uint8_t& r_min, uint8_t& r_max) const;
+	void _fill_waveform_lines(float p_from, float p_to, const Rect2& p_rect, int p_columns, Vector2* r_lines) const;
 
 protected:
 	static void _bind_methods();
 
 public:
+	// Length decoded so far while a stream without a length is still being generated.
 	float get_length() const;
 	float get_max(float p_time, float p_time_next) const;
 	float get_min(float p_time, float p_time_next) const;
+	// Min (x) and max (y) of p_columns equal slices of [p_from, p_to].
+	PoolVector2Array get_min_max_range(float p_from, float p_to, int p_columns) const;
+
+	// Bytes held by the preview data and its pyramid.
+	int get_memory_usage() const;
+
+	int get_level_count() const;
+	// Coarsest level that still has an entry for every column when p_time_span is drawn over p_columns.
+	int get_level_for(float p_time_span, int p_columns) const;
+	// Copy of the interleaved min/max bytes of a level, level 0 is the full resolution.
+	// The generator fills levels in place without locking, so they can't be shared with scripts.
+	// Every call copies the whole level, pick a coarse one with get_level_for.
+	PoolByteArray get_level_data(int p_level) const;
+
+	// One vertical line per pixel column of p_rect, as vertex pairs for canvas_item_add_multiline.
+	void fill_waveform_lines(float p_from, float p_to, const Rect2& p_rect, Vector<Vector2>& r_lines) const;
+	PoolVector2Array get_waveform_lines(float p_from, float p_to, const Rect2& p_rect) const;
 
 	SFXPreview();
 };
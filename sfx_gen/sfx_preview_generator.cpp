@@ -1,96 +1,583 @@
 #include "sfx_preview_generator.h"
 
+#include "core/os/dir_access.h"
+#include "core/os/file_access.h"
+#include "core/os/os.h"
+#include "scene/animation/animation_player.h"
+#include "sfx_min_max.h"
+#include "sfx_min_max_test.h"
 #include "sfx_preview.h"
 #include "servers/audio_server.h"
 
+static const uint32_t SFX_PREVIEW_CACHE_MAGIC = 0x50584653; // "SFXP"
+static const uint32_t SFX_PREVIEW_CACHE_VERSION = 2;
+
+// Streams that don't report a length start with this much room and double it whenever it runs out.
+static const float SFX_PREVIEW_STREAMING_CHUNK_S = 10.0;
+// Looping or generated streams never end, their previews stop here.
+static const float SFX_PREVIEW_STREAMING_MAX_S = 60 * 5;
+
+// Precomputed previews wait for anything requested with the default priority.
+static const int SFX_PREVIEW_PRECOMPUTE_PRIORITY = -1;
+
+static void _read_pcm_frames(const uint8_t* p_data, bool p_16_bits, bool p_stereo, int p_from, AudioFrame* r_frames, int p_count) {
+	int channels = p_stereo ? 2 : 1;
+	if (p_16_bits) {
+		const int16_t* src = reinterpret_cast<const int16_t*>(p_data) + p_from * channels;
+		for (int i = 0; i < p_count; i++) {
+			r_frames[i].l = src[i * channels] / 32768.0;
+			r_frames[i].r = src[i * channels + channels - 1] / 32768.0;
+		}
+	}
+	else {
+		const int8_t* src = reinterpret_cast<const int8_t*>(p_data) + p_from * channels;
+		for (int i = 0; i < p_count; i++) {
+			r_frames[i].l = src[i * channels] / 128.0;
+			r_frames[i].r = src[i * channels + channels - 1] / 128.0;
+		}
+	}
+}
+
+// Widens the min/max entry r_entry to cover p_other. Quantizing keeps the order of the samples,
+// so this is the same as reducing the frames behind both together.
+static void _merge_min_max(uint8_t* r_entry, const uint8_t* p_other) {
+	r_entry[0] = MIN(r_entry[0], p_other[0]);
+	r_entry[1] = MAX(r_entry[1], p_other[1]);
+}
+
 void _SFXPreviewGenerator::_update_emit(ObjectID p_id) {
+	// Sent after every chunk, so a preview whose stream nobody else uses anymore stops here,
+	// without waiting for another preview to finish or be requested.
+	mutex.lock();
+	Preview** preview = previews.getptr(p_id);
+	if (preview && (*preview)->generating.is_set() && !(*preview)->cancelled.is_set() && (*preview)->base_stream->reference_get_count() <= (*preview)->owned_refs) {
+		_cancel_preview(*preview);
+	}
+	mutex.unlock();
+
 	emit_signal("preview_updated", p_id);
 }
 
-void _SFXPreviewGenerator::_preview_thread(void* p_preview) {
-	Preview* preview = static_cast<Preview*>(p_preview);
+void _SFXPreviewGenerator::_preview_finished(ObjectID p_id, bool p_completed) {
+	_reap_previews();
+	// A cancelled preview is gone now, users drop the partial one and ask again.
+	emit_signal("preview_updated", p_id);
+	if (p_completed) {
+		emit_signal("preview_finished", p_id);
+	}
+	_update_precompute_progress();
+}
+
+void _SFXPreviewGenerator::_collect_animation_streams(const Ref<Animation>& p_animation, Node* p_root, HashMap<ObjectID, Ref<AudioStream>>& r_streams) {
+	for (int i = 0; i < p_animation->get_track_count(); i++) {
+		switch (p_animation->track_get_type(i)) {
+		case Animation::TYPE_AUDIO: {
+			for (int j = 0; j < p_animation->track_get_key_count(i); j++) {
+				Ref<AudioStream> stream = p_animation->audio_track_get_key_stream(i, j);
+				if (stream.is_valid()) {
+					r_streams.set(stream->get_instance_id(), stream);
+				}
+			}
+		} break;
+		case Animation::TYPE_VALUE: {
+			NodePath path = p_animation->track_get_path(i);
+			String property = path.get_concatenated_subnames();
+			if (property == "stream") {
+				for (int j = 0; j < p_animation->track_get_key_count(i); j++) {
+					Ref<AudioStream> stream = p_animation->track_get_key_value(i, j);
+					if (stream.is_valid()) {
+						r_streams.set(stream->get_instance_id(), stream);
+					}
+				}
+			}
+			else if (property == "playing" && p_root) {
+				// The player starts whatever stream it holds, which only the node knows.
+				Node* node = p_root->get_node_or_null(path);
+				Ref<AudioStream> stream = node ? node->get("stream") : Variant();
+				if (stream.is_valid()) {
+					r_streams.set(stream->get_instance_id(), stream);
+				}
+			}
+		} break;
+		default:
+			break;
+		}
+	}
+}
+
+int _SFXPreviewGenerator::_precompute(const HashMap<ObjectID, Ref<AudioStream>>& p_streams) {
+	int added = 0;
+	const ObjectID* id = nullptr;
+	while ((id = p_streams.next(id))) {
+		if (precompute_pending.has(*id)) {
+			continue;
+		}
+		// Cached and already generated previews come back finished, they count as done right away.
+		generate_preview(p_streams.get(*id), SFX_PREVIEW_PRECOMPUTE_PRIORITY);
+		precompute_pending.insert(*id);
+		precompute_total++;
+		added++;
+	}
+
+	_update_precompute_progress();
+	return added;
+}
+
+void _SFXPreviewGenerator::_update_precompute_progress() {
+	if (precompute_pending.empty()) {
+		return;
+	}
+
+	int done = 0;
+	mutex.lock();
+	Set<ObjectID>::Element* E = precompute_pending.front();
+	while (E) {
+		Set<ObjectID>::Element* N = E->next();
+		// Missing previews were cancelled or evicted, there is nothing left to wait for.
+		Preview** preview = previews.getptr(E->get());
+		if (!preview || !(*preview)->generating.is_set()) {
+			precompute_pending.erase(E);
+			done++;
+		}
+		E = N;
+	}
+	mutex.unlock();
+
+	if (done == 0) {
+		return;
+	}
+
+	precompute_done += done;
+	emit_signal("precompute_progress", precompute_done, precompute_total);
+	if (precompute_pending.empty()) {
+		precompute_done = 0;
+		precompute_total = 0;
+	}
+}
+
+void _SFXPreviewGenerator::_cancel_preview(Preview* p_preview) {
+	p_preview->cancelled.set();
+
+	List<ObjectID>::Element* E = queue.find(p_preview->id);
+	if (E) {
+		// No worker picked it up yet, so there is nothing to stop.
+		queue.erase(E);
+		p_preview->generating.clear();
+	}
+}
+
+void _SFXPreviewGenerator::_reap_previews() {
+	List<ObjectID> to_erase;
+
+	mutex.lock();
+
+	const ObjectID* id = nullptr;
+	while ((id = previews.next(id))) {
+		Preview* preview = previews.get(*id);
+
+		if (preview->generating.is_set()) {
+			// The preview only holds the stream alive, finishing it is wasted work.
+			if (!preview->cancelled.is_set() && preview->base_stream->reference_get_count() <= preview->owned_refs) {
+				_cancel_preview(preview);
+			}
+			continue;
+		}
+
+		if (preview->cancelled.is_set()) {
+			to_erase.push_back(*id);
+			continue;
+		}
+
+		// Done, let the stream go so its owners can free it. The entry stays for as long as the stream lives.
+		preview->playback.unref();
+		preview->sample.unref();
+		preview->base_stream.unref();
+		if (!ObjectDB::get_instance(*id)) {
+			to_erase.push_back(*id);
+		}
+	}
+
+	for (List<ObjectID>::Element* E = to_erase.front(); E; E = E->next()) {
+		memdelete(previews.get(E->get()));
+		previews.erase(E->get());
+	}
+
+	if (memory_budget > 0) {
+		int64_t usage = 0;
+		Vector<Preview*> evictable;
+		id = nullptr;
+		while ((id = previews.next(id))) {
+			Preview* preview = previews.get(*id);
+			usage += preview->preview->get_memory_usage();
+			if (!preview->generating.is_set() && preview->preview->reference_get_count() <= 1) {
+				evictable.push_back(preview);
+			}
+		}
+
+		if (usage > memory_budget) {
+			evictable.sort_custom<PreviewLRUCompare>();
+			for (int i = 0; i < evictable.size() && usage > memory_budget; i++) {
+				usage -= evictable[i]->preview->get_memory_usage();
+				previews.erase(evictable[i]->id);
+				memdelete(evictable[i]);
+			}
+		}
+	}
+
+	mutex.unlock();
+}
+
+bool _SFXPreviewGenerator::_load_cached_preview(Preview* p_preview) {
+	FileAccessRef f = FileAccess::open(p_preview->cache_file, FileAccess::READ);
+	if (!f) {
+		return false;
+	}
+
+	if (f->get_32() != SFX_PREVIEW_CACHE_MAGIC || f->get_32() != SFX_PREVIEW_CACHE_VERSION || f->get_64() != p_preview->modified_time) {
+		return false;
+	}
+
+	if (int(f->get_32()) != p_preview->points_per_second) {
+		return false;
+	}
+
+	float length = f->get_float();
+	uint32_t size = f->get_32();
+	if (size % 2 != 0 || f->get_len() - f->get_position() != size) {
+		return false;
+	}
+
+	// The whole entry is read in one go straight into the preview.
+	Vector<uint8_t> data;
+	data.resize(size);
+	if (f->get_buffer(data.ptrw(), size) != size) {
+		return false;
+	}
+
+	p_preview->preview->preview = data;
+	p_preview->preview->length = length;
+	p_preview->preview->_build_mips();
+	p_preview->preview->written.set(size / 2);
+	return true;
+}
+
+void _SFXPreviewGenerator::_save_cached_preview(const Preview* p_preview) {
+	if (p_preview->cache_file.empty()) {
+		return;
+	}
+
+	FileAccessRef f = FileAccess::open(p_preview->cache_file, FileAccess::WRITE);
+	ERR_FAIL_COND_MSG(!f, "Can't write SFX preview cache file: " + p_preview->cache_file + ".");
+
+	const Vector<uint8_t>& data = p_preview->preview->preview;
+	f->store_32(SFX_PREVIEW_CACHE_MAGIC);
+	f->store_32(SFX_PREVIEW_CACHE_VERSION);
+	f->store_64(p_preview->modified_time);
+	f->store_32(p_preview->points_per_second);
+	f->store_float(p_preview->preview->length);
+	f->store_32(data.size());
+	f->store_buffer(data.ptr(), data.size());
+}
+
+void _SFXPreviewGenerator::_setup_source(Preview* p_preview) const {
+	p_preview->source_rate = AudioServer::get_singleton()->get_mix_rate();
+	p_preview->rate_scale = 1.0;
+
+	// Other streams only resample inside their playback, which has no way to skip it.
+	Ref<AudioStreamSample> sample = p_preview->base_stream;
+	if (!decode_native_rate || sample.is_null() || sample->get_mix_rate() <= 0) {
+		return;
+	}
+
+	if (sample->get_format() == AudioStreamSample::FORMAT_IMA_ADPCM) {
+		// Compressed, let the playback decode but step exactly one source frame per mixed frame.
+		p_preview->rate_scale = p_preview->source_rate / sample->get_mix_rate();
+	}
+	else {
+		p_preview->sample = sample;
+	}
+	p_preview->source_rate = sample->get_mix_rate();
+}
+
+void _SFXPreviewGenerator::_worker_thread(void* p_self) {
+	_SFXPreviewGenerator* self = static_cast<_SFXPreviewGenerator*>(p_self);
+
+	while (!self->exiting.is_set()) {
+		Preview* preview = self->_take_job();
+		if (!preview) {
+			self->jobs.wait();
+			continue;
+		}
+		_generate_preview(preview);
+	}
+}
+
+_SFXPreviewGenerator::Preview* _SFXPreviewGenerator::_take_job() {
+	mutex.lock();
+
+	List<ObjectID>::Element* best = nullptr;
+	Preview* best_preview = nullptr;
+	for (List<ObjectID>::Element* E = queue.front(); E; E = E->next()) {
+		Preview** P = previews.getptr(E->get());
+		if (!P) {
+			continue;
+		}
+		Preview* preview = *P;
+		if (!best_preview || preview->priority > best_preview->priority || (preview->priority == best_preview->priority && preview->request > best_preview->request)) {
+			best = E;
+			best_preview = preview;
+		}
+	}
+
+	if (best) {
+		queue.erase(best);
+	}
+
+	mutex.unlock();
+	return best_preview;
+}
+
+void _SFXPreviewGenerator::_start_workers() {
+	while (workers.size() < max_threads) {
+		Thread* thread = memnew(Thread);
+		thread->start(_worker_thread, this);
+		workers.push_back(thread);
+	}
+}
+
+void _SFXPreviewGenerator::_stop_workers() {
+	// Workers put the preview they are on back in the queue at its next chunk, anything queued waits for the next start.
+	exiting.set();
+	for (int i = 0; i < workers.size(); i++) {
+		jobs.post();
+	}
+	for (int i = 0; i < workers.size(); i++) {
+		workers[i]->wait_to_finish();
+		memdelete(workers[i]);
+	}
+	workers.clear();
+	exiting.clear();
+}
+
+void _SFXPreviewGenerator::_generate_preview(Preview* p_preview) {
+	Preview* preview = p_preview;
 
 	float muxbuff_chunk_s = 0.25;
 
-	int mixbuff_chunk_frames = AudioServer::get_singleton()->get_mix_rate() * muxbuff_chunk_s;
+	int mixbuff_chunk_frames = preview->source_rate * muxbuff_chunk_s;
 
 	Vector<AudioFrame> mix_chunk;
 	mix_chunk.resize(mixbuff_chunk_frames);
 
-	int frames_total = AudioServer::get_singleton()->get_mix_rate() * preview->preview->length;
-	int frames_todo = frames_total;
-
-	preview->playback->start();
+	PoolVector<uint8_t> pcm;
+	PoolVector<uint8_t>::Read pcm_read;
+	bool pcm_16_bits = false;
+	bool pcm_stereo = false;
+
+	SFXPreview* sfx_preview = preview->preview.ptr();
+	bool streaming = sfx_preview->streaming;
+
+	int frames_total;
+	if (preview->sample.is_valid()) {
+		pcm = preview->sample->get_data();
+		pcm_read = pcm.read();
+		pcm_16_bits = preview->sample->get_format() == AudioStreamSample::FORMAT_16_BITS;
+		pcm_stereo = preview->sample->is_stereo();
+		frames_total = pcm.size() / ((pcm_16_bits ? 2 : 1) * (pcm_stereo ? 2 : 1));
+	}
+	else if (streaming) {
+		frames_total = preview->source_rate * SFX_PREVIEW_STREAMING_MAX_S;
+		preview->playback->start();
+	}
+	else {
+		frames_total = preview->source_rate * sfx_preview->length;
+		preview->playback->start();
+	}
 
-	while (frames_todo) {
-		int ofs_write = uint64_t(frames_total - frames_todo) * uint64_t(preview->preview->preview.size() / 2) / uint64_t(frames_total);
-		int to_read = MIN(frames_todo, mixbuff_chunk_frames);
-		int to_write = uint64_t(to_read) * uint64_t(preview->preview->preview.size() / 2) / uint64_t(frames_total);
-		to_write = MIN(to_write, (preview->preview->preview.size() / 2) - ofs_write);
+	// Readers never touch the buffer's storage, only entries below the written watermark.
+	// Growing it moves the storage, so that happens under the preview's lock.
+	uint8_t* preview_data = sfx_preview->preview.ptrw();
+	int preview_size = sfx_preview->preview.size() / 2;
+	double points_per_frame = streaming ? preview->points_per_second / preview->source_rate : double(preview_size) / frames_total;
+
+	int frames_done = 0;
+	int ofs_write = 0;
+	// Min/max of the frames read past the last entry written, they go into the next one.
+	uint8_t carry[2];
+	bool carrying = false;
+	bool ended = false;
+	bool interrupted = false;
+	while (frames_done < frames_total && !ended && !preview->cancelled.is_set()) {
+		if (singleton->exiting.is_set()) {
+			interrupted = true;
+			break;
+		}
 
-		preview->playback->mix(mix_chunk.ptrw(), 1.0, to_read);
+		int to_read = MIN(frames_total - frames_done, mixbuff_chunk_frames);
+		int chunk_from = frames_done;
 
-		for (int i = 0; i < to_write; i++) {
-			float max = -1000;
-			float min = 1000;
-			int from = uint64_t(i) * to_read / to_write;
-			int to = (uint64_t(i) + 1) * to_read / to_write;
-			to = MIN(to, to_read);
-			from = MIN(from, to_read - 1);
-			if (to == from) {
-				to = from + 1;
-			}
+		if (preview->sample.is_valid()) {
+			_read_pcm_frames(pcm_read.ptr(), pcm_16_bits, pcm_stereo, frames_done, mix_chunk.ptrw(), to_read);
+		}
+		else {
+			preview->playback->mix(mix_chunk.ptrw(), preview->rate_scale, to_read);
+			// The playback fills the rest of the chunk with silence once it runs out.
+			ended = streaming && !preview->playback->is_playing();
+		}
+		frames_done += to_read;
 
-			for (int j = from; j < to; j++) {
-				max = MAX(max, mix_chunk[j].l);
-				max = MAX(max, mix_chunk[j].r);
+		int ofs_end = frames_done * points_per_frame;
+		if (!streaming) {
+			ofs_end = MIN(ofs_end, preview_size);
+		}
+		else if (ofs_end > preview_size) {
+			int capacity = MAX(ofs_end, preview_size * 2);
+			sfx_preview->_resize(capacity, capacity / float(preview->points_per_second), true);
+			preview_data = sfx_preview->preview.ptrw();
+			preview_size = capacity;
+		}
 
-				min = MIN(min, mix_chunk[j].l);
-				min = MIN(min, mix_chunk[j].r);
+		// Entries rarely end where chunks do, and below four points per second most chunks don't finish one.
+		// The chunk is split where the last entry it completes ends, the frames after that are carried into
+		// the next entry, so every entry covers all of its frames whatever the rate.
+		bool last = frames_done >= frames_total || ended;
+		int to_write = ofs_end - ofs_write;
+		int mips_from = ofs_write;
+		int split = 0;
+		if (to_write > 0) {
+			split = last ? to_read : CLAMP(int(Math::ceil(ofs_end / points_per_frame)) - chunk_from, 1, to_read);
+			sfx_reduce_min_max(mix_chunk.ptr(), split, to_write, preview_data + ofs_write * 2);
+			if (carrying) {
+				_merge_min_max(preview_data + ofs_write * 2, carry);
+				carrying = false;
 			}
+		}
 
-			uint8_t pfrom = CLAMP((min * 0.5 + 0.5) * 255, 0, 255);
-			uint8_t pto = CLAMP((max * 0.5 + 0.5) * 255, 0, 255);
+		if (split < to_read) {
+			uint8_t rest[2];
+			sfx_reduce_min_max(mix_chunk.ptr() + split, to_read - split, 1, rest);
+			if (carrying) {
+				_merge_min_max(carry, rest);
+			}
+			else {
+				carry[0] = rest[0];
+				carry[1] = rest[1];
+				carrying = true;
+			}
+		}
 
-			preview->preview->preview.write[(ofs_write + i) * 2 + 0] = pfrom;
-			preview->preview->preview.write[(ofs_write + i) * 2 + 1] = pto;
+		if (last && carrying && ofs_end > 0) {
+			// The stream ended inside an entry already written, nothing follows to take the frames.
+			_merge_min_max(preview_data + (ofs_end - 1) * 2, carry);
+			mips_from = MIN(mips_from, ofs_end - 1);
+			carrying = false;
 		}
 
-		frames_todo -= to_read;
+		sfx_preview->_update_mips(mips_from, ofs_end);
+		sfx_preview->written.set(ofs_end);
+		ofs_write = ofs_end;
+
 		singleton->call_deferred("_update_emit", preview->id);
 	}
 
-	preview->playback->stop();
+	if (preview->sample.is_null()) {
+		preview->playback->stop();
+	}
+
+	if (interrupted) {
+		// The workers are being stopped. The preview stays generating and starts over with the next ones,
+		// rewriting the same entries, or is freed with the generator.
+		singleton->mutex.lock();
+		singleton->queue.push_back(preview->id);
+		singleton->mutex.unlock();
+		return;
+	}
 
+	bool completed = !preview->cancelled.is_set();
+	if (completed) {
+		if (streaming) {
+			// Settle on what was decoded, get_length() now reports the stream's actual length.
+			sfx_preview->_resize(MAX(1, ofs_write), frames_done / preview->source_rate, false);
+		}
+		else {
+			// Rounding may leave the last few entries untouched, they stay silent.
+			sfx_preview->written.set(preview_size);
+		}
+		_save_cached_preview(preview);
+	}
+
+	// The main thread may free the preview as soon as generating is clear.
+	ObjectID id = preview->id;
 	preview->generating.clear();
+	singleton->call_deferred("_preview_finished", id, completed);
 }
 
-Ref<SFXPreview> _SFXPreviewGenerator::generate_preview(const Ref<AudioStream>& p_stream) {
+Ref<SFXPreview> _SFXPreviewGenerator::generate_preview(const Ref<AudioStream>& p_stream, int p_priority) {
 	ERR_FAIL_COND_V(p_stream.is_null(), Ref<SFXPreview>());
 
-	if (previews.has(p_stream->get_instance_id())) {
-		return previews[p_stream->get_instance_id()].preview;
+	ObjectID id = p_stream->get_instance_id();
+
+	mutex.lock();
+
+	Preview** existing = previews.getptr(id);
+	if (existing) {
+		// Asking again for a queued preview moves it ahead of the ones nobody asked for since.
+		(*existing)->priority = p_priority;
+		(*existing)->request = ++request_serial;
+		Ref<SFXPreview> preview = (*existing)->preview;
+		mutex.unlock();
+		return preview;
 	}
 
 	//no preview exists
 
-	previews[p_stream->get_instance_id()] = Preview();
+	// A good moment to drop previews of freed streams, without walking them on every request.
+	_reap_previews();
 
-	Preview* preview = &previews[p_stream->get_instance_id()];
-	preview->base_stream = p_stream;
-	preview->playback = preview->base_stream->instance_playback();
-	preview->generating.set();
-	preview->id = p_stream->get_instance_id();
+	Preview* preview = memnew(Preview);
+	previews.set(id, preview);
+	preview->id = id;
+	preview->priority = p_priority;
+	preview->request = ++request_serial;
+	preview->points_per_second = points_per_second;
+	preview->preview.instance();
+
+	// No worker looks at the preview before it is queued, so the cache is read and the stream set up
+	// without holding the lock every worker needs to take its next job.
+	mutex.unlock();
 
-	float len_s = preview->base_stream->get_length();
-	if (len_s == 0) {
-		len_s = 60 * 5; //five minutes
+	String path = p_stream->get_path();
+	if (!cache_dir.empty() && path.is_resource_file()) {
+		preview->modified_time = FileAccess::get_modified_time(path);
+		if (preview->modified_time != 0) {
+			preview->cache_file = cache_dir.plus_file(path.md5_text() + ".sfxp");
+		}
+	}
+
+	if (!preview->cache_file.empty() && _load_cached_preview(preview)) {
+		return preview->preview;
+	}
+
+	if (!preview->cache_file.empty() && !cache_dir_created) {
+		DirAccessRef da = DirAccess::create_for_path(cache_dir);
+		da->make_dir_recursive(cache_dir);
+		cache_dir_created = true;
+	}
+
+	float len_s = p_stream->get_length();
+	bool streaming = len_s == 0;
+	if (streaming) {
+		len_s = SFX_PREVIEW_STREAMING_CHUNK_S;
 	}
 
-	int frames = AudioServer::get_singleton()->get_mix_rate() * len_s;
+	int refs = p_stream->reference_get_count();
+	preview->base_stream = p_stream;
+	preview->playback = p_stream->instance_playback();
+	_setup_source(preview);
+	preview->owned_refs = p_stream->reference_get_count() - refs;
 
 	Vector<uint8_t> maxmin;
-	int pw = frames / 20;
+	int pw = MAX(1, int(points_per_second * len_s));
 	maxmin.resize(pw * 2);
 	{
 		uint8_t* ptr = maxmin.ptrw();
@@ -99,55 +586,181 @@ Ref<SFXPreview> _SFXPreviewGenerator::generate_preview(const Ref<AudioStream>& p
 		}
 	}
 
-	preview->preview.instance();
 	preview->preview->preview = maxmin;
 	preview->preview->length = len_s;
+	preview->preview->streaming = streaming && preview->sample.is_null();
+	preview->preview->_build_mips();
+
+	Ref<SFXPreview> result = preview->preview;
+	bool queued = preview->playback.is_valid();
+	if (queued) {
+		preview->generating.set();
+		mutex.lock();
+		queue.push_back(id);
+		mutex.unlock();
+	}
+
+	if (queued) {
+		_start_workers();
+		jobs.post();
+	}
 
-	if (preview->playback.is_valid()) {
-		preview->thread = memnew(Thread);
-		preview->thread->start(_preview_thread, preview);
+	return result;
+}
+
+void _SFXPreviewGenerator::cancel_preview(const Ref<AudioStream>& p_stream) {
+	ERR_FAIL_COND(p_stream.is_null());
+
+	mutex.lock();
+	Preview** preview = previews.getptr(p_stream->get_instance_id());
+	if (preview && (*preview)->generating.is_set()) {
+		_cancel_preview(*preview);
+	}
+	mutex.unlock();
+
+	// Drops it right away when no worker had it, the next request starts over.
+	_reap_previews();
+}
+
+int _SFXPreviewGenerator::precompute_for_animation(const Ref<Animation>& p_animation, Node* p_root) {
+	ERR_FAIL_COND_V(p_animation.is_null(), 0);
+
+	HashMap<ObjectID, Ref<AudioStream>> streams;
+	_collect_animation_streams(p_animation, p_root, streams);
+	return _precompute(streams);
+}
+
+int _SFXPreviewGenerator::precompute_for_animation_player(AnimationPlayer* p_player) {
+	ERR_FAIL_NULL_V(p_player, 0);
+
+	Node* root = p_player->get_node_or_null(p_player->get_root());
+
+	// Animations often share their streams, collecting them all first queues each one once.
+	HashMap<ObjectID, Ref<AudioStream>> streams;
+	List<StringName> animations;
+	p_player->get_animation_list(&animations);
+	for (List<StringName>::Element* E = animations.front(); E; E = E->next()) {
+		_collect_animation_streams(p_player->get_animation(E->get()), root, streams);
+	}
+	return _precompute(streams);
+}
+
+void _SFXPreviewGenerator::set_max_threads(int p_max_threads) {
+	ERR_FAIL_COND(p_max_threads < 1);
+	if (max_threads == p_max_threads) {
+		return;
+	}
+
+	bool running = !workers.empty();
+	_stop_workers();
+	max_threads = p_max_threads;
+	if (running) {
+		_start_workers();
+	}
+}
+
+int _SFXPreviewGenerator::get_max_threads() const {
+	return max_threads;
+}
+
+void _SFXPreviewGenerator::set_cache_dir(const String& p_dir) {
+	cache_dir = p_dir;
+	cache_dir_created = false;
+}
+
+String _SFXPreviewGenerator::get_cache_dir() const {
+	return cache_dir;
+}
+
+void _SFXPreviewGenerator::set_points_per_second(int p_points) {
+	ERR_FAIL_COND(p_points < 1);
+	points_per_second = p_points;
+}
+
+int _SFXPreviewGenerator::get_points_per_second() const {
+	return points_per_second;
+}
+
+void _SFXPreviewGenerator::set_decode_native_rate(bool p_enable) {
+	decode_native_rate = p_enable;
+}
+
+bool _SFXPreviewGenerator::is_decoding_native_rate() const {
+	return decode_native_rate;
+}
+
+void _SFXPreviewGenerator::set_memory_budget(int64_t p_bytes) {
+	memory_budget = p_bytes;
+	_reap_previews();
+}
+
+int64_t _SFXPreviewGenerator::get_memory_budget() const {
+	return memory_budget;
+}
+
+int64_t _SFXPreviewGenerator::get_memory_usage() {
+	int64_t usage = 0;
+	mutex.lock();
+	const ObjectID* id = nullptr;
+	while ((id = previews.next(id))) {
+		usage += previews.get(*id)->preview->get_memory_usage();
 	}
+	mutex.unlock();
+	return usage;
+}
 
-	return preview->preview;
+#ifdef DEBUG_ENABLED
+bool _SFXPreviewGenerator::run_min_max_tests() {
+	return sfx_min_max_run_tests();
 }
+#endif
 
 void _SFXPreviewGenerator::_bind_methods() {
 	ClassDB::bind_method("_update_emit", &_SFXPreviewGenerator::_update_emit);
-	ClassDB::bind_method(D_METHOD("generate_preview", "stream"), &_SFXPreviewGenerator::generate_preview);
+	ClassDB::bind_method("_preview_finished", &_SFXPreviewGenerator::_preview_finished);
+	ClassDB::bind_method(D_METHOD("generate_preview", "stream", "priority"), &_SFXPreviewGenerator::generate_preview, DEFVAL(0));
+	ClassDB::bind_method(D_METHOD("cancel_preview", "stream"), &_SFXPreviewGenerator::cancel_preview);
+	ClassDB::bind_method(D_METHOD("precompute_for_animation", "animation", "root"), &_SFXPreviewGenerator::precompute_for_animation, DEFVAL(Variant()));
+	ClassDB::bind_method(D_METHOD("precompute_for_animation_player", "player"), &_SFXPreviewGenerator::precompute_for_animation_player);
+	ClassDB::bind_method(D_METHOD("set_max_threads", "max_threads"), &_SFXPreviewGenerator::set_max_threads);
+	ClassDB::bind_method("get_max_threads", &_SFXPreviewGenerator::get_max_threads);
+	ClassDB::bind_method(D_METHOD("set_cache_dir", "dir"), &_SFXPreviewGenerator::set_cache_dir);
+	ClassDB::bind_method("get_cache_dir", &_SFXPreviewGenerator::get_cache_dir);
+	ClassDB::bind_method(D_METHOD("set_points_per_second", "points"), &_SFXPreviewGenerator::set_points_per_second);
+	ClassDB::bind_method("get_points_per_second", &_SFXPreviewGenerator::get_points_per_second);
+	ClassDB::bind_method(D_METHOD("set_decode_native_rate", "enable"), &_SFXPreviewGenerator::set_decode_native_rate);
+	ClassDB::bind_method("is_decoding_native_rate", &_SFXPreviewGenerator::is_decoding_native_rate);
+	ClassDB::bind_method(D_METHOD("set_memory_budget", "bytes"), &_SFXPreviewGenerator::set_memory_budget);
+	ClassDB::bind_method("get_memory_budget", &_SFXPreviewGenerator::get_memory_budget);
+	ClassDB::bind_method("get_memory_usage", &_SFXPreviewGenerator::get_memory_usage);
+#ifdef DEBUG_ENABLED
+	ClassDB::bind_method("run_min_max_tests", &_SFXPreviewGenerator::run_min_max_tests);
+#endif
+
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "max_threads", PROPERTY_HINT_RANGE, "1,64,1"), "set_max_threads", "get_max_threads");
+	ADD_PROPERTY(PropertyInfo(Variant::STRING, "cache_dir", PROPERTY_HINT_DIR), "set_cache_dir", "get_cache_dir");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "points_per_second", PROPERTY_HINT_RANGE, "1,10000,1,or_greater"), "set_points_per_second", "get_points_per_second");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "decode_native_rate"), "set_decode_native_rate", "is_decoding_native_rate");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "memory_budget"), "set_memory_budget", "get_memory_budget");
 
 	ADD_SIGNAL(MethodInfo("preview_updated", PropertyInfo(Variant::INT, "obj_id")));
+	ADD_SIGNAL(MethodInfo("preview_finished", PropertyInfo(Variant::INT, "obj_id")));
+	ADD_SIGNAL(MethodInfo("precompute_progress", PropertyInfo(Variant::INT, "completed"), PropertyInfo(Variant::INT, "total")));
 }
 
 _SFXPreviewGenerator* _SFXPreviewGenerator::singleton = nullptr;
 
-void _SFXPreviewGenerator::_notification(int p_what) {
-	switch (p_what) {
-	case NOTIFICATION_PROCESS: {
-		List<ObjectID> to_erase;
-		const HashMap<ObjectID, Preview>::Pair *key_values;
-		previews.get_key_value_ptr_array(&key_values);
-		for (int i = 0; i < previews.size(); ++i) {
-			HashMap<ObjectID, Preview>::Pair kv = key_values[i];
-			if (!kv.data.generating.is_set()) {
-				if (kv.data.thread) {
-					kv.data.thread->wait_to_finish();
-					memdelete(kv.data.thread);
-					kv.data.thread = nullptr;
-				}
-				if (!ObjectDB::get_instance(kv.key)) { //no longer in use, get rid of preview
-					to_erase.push_back(kv.key);
-				}
-			}
-		}
-
-		while (to_erase.front()) {
-			previews.erase(to_erase.front()->get());
-			to_erase.pop_front();
-		}
-	} break;
-	}
+_SFXPreviewGenerator::_SFXPreviewGenerator() {
+	// Leave a core to the main thread, decoding every clip at once only thrashes.
+	max_threads = MAX(1, OS::get_singleton()->get_processor_count() - 1);
+	cache_dir = "user://sfx_preview_cache";
 }
 
-_SFXPreviewGenerator::_SFXPreviewGenerator() {
-	set_process(true);
+_SFXPreviewGenerator::~_SFXPreviewGenerator() {
+	_stop_workers();
+
+	const ObjectID* id = nullptr;
+	while ((id = previews.next(id))) {
+		memdelete(previews.get(*id));
+	}
 }
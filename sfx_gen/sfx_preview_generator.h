@@ -1,9 +1,16 @@
 #ifndef SFX_PREVIEW_GENERATOR_H
 #define SFX_PREVIEW_GENERATOR_H
 
+#include "core/os/mutex.h"
+#include "core/os/semaphore.h"
+#include "core/os/thread.h"
+#include "core/set.h"
 #include "scene/main/node.h"
+#include "scene/resources/animation.h"
+#include "scene/resources/audio_stream_sample.h"
 #include "servers/audio/audio_stream.h"
 
+class AnimationPlayer;
 class SFXPreview;
 
 class _SFXPreviewGenerator : public Node {
@@ -11,42 +18,90 @@ class _SFXPreviewGenerator : public Node {
 
 	static _SFXPreviewGenerator* singleton;
 
+	// Previews live on the heap so a worker can keep using one while the map changes. They are only
+	// freed on the main thread, once generating is clear, which is the last thing a worker touches.
 	struct Preview {
 		Ref<SFXPreview> preview;
 		Ref<AudioStream> base_stream;
 		Ref<AudioStreamPlayback> playback;
 		SafeFlag generating;
+		// Set once nothing but the preview uses the stream, the worker stops at the next chunk.
+		SafeFlag cancelled;
+		int owned_refs = 0; // References to base_stream held by the preview and its playback.
 		ObjectID id;
-		Thread* thread = nullptr;
-
-		// Needed for the bookkeeping of the Map
-		void operator=(const Preview& p_rhs) {
-			preview = p_rhs.preview;
-			base_stream = p_rhs.base_stream;
-			playback = p_rhs.playback;
-			generating.set_to(generating.is_set());
-			id = p_rhs.id;
-			thread = p_rhs.thread;
-		}
-		Preview(const Preview& p_rhs) {
-			preview = p_rhs.preview;
-			base_stream = p_rhs.base_stream;
-			playback = p_rhs.playback;
-			generating.set_to(generating.is_set());
-			id = p_rhs.id;
-			thread = p_rhs.thread;
+		int priority = 0;
+		uint64_t request = 0; // Serial of the last generate_preview call for this stream, orders the queue and eviction.
+		String cache_file; // Empty when the stream can't be cached.
+		uint64_t modified_time = 0;
+		// PCM samples are read as they are stored, skipping the playback and its resampler.
+		Ref<AudioStreamSample> sample;
+		float source_rate = 0; // Frames per second the stream is read at.
+		float rate_scale = 1.0;
+		int points_per_second = 0;
+	};
+
+	struct PreviewLRUCompare {
+		_FORCE_INLINE_ bool operator()(const Preview* p_a, const Preview* p_b) const {
+			return p_a->request < p_b->request;
 		}
-		Preview() {}
 	};
 
-	HashMap<ObjectID, Preview> previews;
+	// Guards previews and queue, workers look previews up while the main thread adds them.
+	Mutex mutex;
+	HashMap<ObjectID, Preview*> previews;
+
+	// Previews waiting for a worker. The highest priority goes first, then the most recently
+	// requested, so clips drawn on screen overtake the ones scrolled away since they were queued.
+	List<ObjectID> queue;
+	uint64_t request_serial = 0;
+
+	int points_per_second = 500;
+	bool decode_native_rate = true;
+
+	// Finished previews beyond this many bytes are dropped, least recently requested first.
+	// They come back from the disk cache, or are generated again, the next time they are asked for.
+	// Previews referenced outside the generator, like the ones of clips on screen, are never dropped,
+	// that would free nothing and only make the next request build a second copy.
+	int64_t memory_budget = 64 * 1024 * 1024;
+
+	void _setup_source(Preview* p_preview) const;
+
+	Vector<Thread*> workers;
+	int max_threads = 1;
+	Semaphore jobs;
+	SafeFlag exiting;
+
+	// Finished previews of resource files are kept here, keyed by path and checked against its modified time.
+	String cache_dir;
+	bool cache_dir_created = false;
+
+	// Streams of the current precompute batch that are still being generated. Main thread only,
+	// the counters reset once the batch drains.
+	Set<ObjectID> precompute_pending;
+	int precompute_total = 0;
+	int precompute_done = 0;
+
+	static void _collect_animation_streams(const Ref<Animation>& p_animation, Node* p_root, HashMap<ObjectID, Ref<AudioStream>>& r_streams);
+	int _precompute(const HashMap<ObjectID, Ref<AudioStream>>& p_streams);
+	void _update_precompute_progress();
 
-	static void _preview_thread(void* p_preview);
+	bool _load_cached_preview(Preview* p_preview);
+	static void _save_cached_preview(const Preview* p_preview);
+
+	static void _worker_thread(void* p_self);
+	static void _generate_preview(Preview* p_preview);
+	Preview* _take_job();
+	void _start_workers();
+	void _stop_workers();
+
+	void _cancel_preview(Preview* p_preview);
+	void _reap_previews();
 
 	void _update_emit(ObjectID p_id);
+	// Emits preview_finished too when the preview was generated to the end, its length is final then.
+	void _preview_finished(ObjectID p_id, bool p_completed);
 
 protected:
-	void _notification(int p_what);
 	static void _bind_methods();
 
 public:
@@ -57,9 +112,38 @@ public:
 		return singleton;
 	}
 
-	Ref<SFXPreview> generate_preview(const Ref<AudioStream>& p_stream);
+	Ref<SFXPreview> generate_preview(const Ref<AudioStream>& p_stream, int p_priority = 0);
+	void cancel_preview(const Ref<AudioStream>& p_stream);
+
+	// Queue previews of every stream an animation plays, behind the ones requested for drawing.
+	// "playing" tracks of stream players are resolved from p_root, they are skipped without it.
+	// Returns how many streams were added to the batch, progress is reported by precompute_progress.
+	int precompute_for_animation(const Ref<Animation>& p_animation, Node* p_root = nullptr);
+	int precompute_for_animation_player(AnimationPlayer* p_player);
+
+	void set_max_threads(int p_max_threads);
+	int get_max_threads() const;
+
+	void set_cache_dir(const String& p_dir);
+	String get_cache_dir() const;
+
+	void set_points_per_second(int p_points);
+	int get_points_per_second() const;
+
+	void set_decode_native_rate(bool p_enable);
+	bool is_decoding_native_rate() const;
+
+	void set_memory_budget(int64_t p_bytes);
+	int64_t get_memory_budget() const;
+	int64_t get_memory_usage();
+
+#ifdef DEBUG_ENABLED
+	// Entry point for the min/max reduction tests, see sfx_min_max_test.h.
+	bool run_min_max_tests();
+#endif
 
 	_SFXPreviewGenerator();
+	~_SFXPreviewGenerator();
 };
 
 #endif
@@ -0,0 +1,102 @@
+#include "key_interval_index.h"
+
+void KeyIntervalIndex::clear() {
+	intervals.clear();
+	max_level = -1;
+}
+
+void KeyIntervalIndex::add(int p_key, float p_start, float p_end) {
+	Interval interval;
+	interval.key = p_key;
+	interval.start = MIN(p_start, p_end);
+	interval.end = MAX(p_start, p_end);
+	intervals.push_back(interval);
+}
+
+void KeyIntervalIndex::build() {
+	intervals.sort();
+	_build_tree();
+}
+
+void KeyIntervalIndex::_build_tree() {
+	max_level = -1;
+	int n = intervals.size();
+	if (n == 0) {
+		return;
+	}
+
+	Interval* a = intervals.ptrw();
+
+	// Leaves sit on even indices, a node of level k sits on indices whose k lowest bits are set.
+	int last_i = 0;
+	float last = 0;
+	for (int i = 0; i < n; i += 2) {
+		last_i = i;
+		last = a[i].max_end = a[i].end;
+	}
+
+	int k = 1;
+	for (; (1 << k) <= n; k++) {
+		int x = 1 << (k - 1);
+		int i0 = (x << 1) - 1;
+		int step = x << 2;
+		for (int i = i0; i < n; i += step) {
+			float end_left = a[i - x].max_end;
+			// The right child may be past the end of the array, the last node of the level below covers it.
+			float end_right = i + x < n ? a[i + x].max_end : last;
+			a[i].max_end = MAX(a[i].end, MAX(end_left, end_right));
+		}
+		last_i = ((last_i >> k) & 1) ? last_i - x : last_i + x;
+		if (last_i < n && a[last_i].max_end > last) {
+			last = a[last_i].max_end;
+		}
+	}
+	max_level = k - 1;
+}
+
+void KeyIntervalIndex::query(float p_from, float p_to, Vector<int>& r_keys) const {
+	if (max_level < 0) {
+		return;
+	}
+
+	struct StackItem {
+		int x;
+		int k;
+		bool visited_left;
+	};
+
+	const Interval* a = intervals.ptr();
+	int n = intervals.size();
+
+	// At most two entries are pushed per level.
+	StackItem stack[64];
+	int top = 0;
+	stack[top++] = { (1 << max_level) - 1, max_level, false };
+
+	while (top > 0) {
+		StackItem z = stack[--top];
+		if (z.k <= 3) {
+			// Small subtree, a linear scan is cheaper than descending further.
+			int i0 = z.x >> z.k << z.k;
+			int i1 = MIN(i0 + (1 << (z.k + 1)) - 1, n);
+			for (int i = i0; i < i1 && a[i].start <= p_to; i++) {
+				if (p_from <= a[i].end) {
+					r_keys.push_back(a[i].key);
+				}
+			}
+		}
+		else if (!z.visited_left) {
+			int y = z.x - (1 << (z.k - 1));
+			stack[top++] = { z.x, z.k, true };
+			if (y >= n || a[y].max_end >= p_from) {
+				stack[top++] = { y, z.k - 1, false };
+			}
+		}
+		else if (z.x < n && a[z.x].start <= p_to) {
+			if (p_from <= a[z.x].end) {
+				r_keys.push_back(a[z.x].key);
+			}
+			stack[top++] = { z.x + (1 << (z.k - 1)), z.k - 1, false };
+		}
+	}
+}
@@ -0,0 +1,35 @@
+#ifndef KEY_INTERVAL_INDEX_H
+#define KEY_INTERVAL_INDEX_H
+
+#include "core/vector.h"
+
+// Static interval index over the time extents of a track's keys.
+// Intervals are sorted by start and laid out as an implicit binary tree where every
+// node also stores the largest end of its subtree, so overlap queries are O(log n + k).
+class KeyIntervalIndex {
+	struct Interval {
+		float start = 0;
+		float end = 0;
+		float max_end = 0;
+		int key = 0;
+
+		bool operator<(const Interval& p_other) const { return start < p_other.start; }
+	};
+
+	Vector<Interval> intervals;
+	int max_level = -1;
+
+	void _build_tree();
+
+public:
+	void clear();
+	void add(int p_key, float p_start, float p_end);
+	void build();
+
+	// Appends the keys whose interval overlaps [p_from, p_to], bounds included, in no particular order.
+	void query(float p_from, float p_to, Vector<int>& r_keys) const;
+
+	int size() const { return intervals.size(); }
+};
+
+#endif
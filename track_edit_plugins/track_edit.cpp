@@ -1,5 +1,7 @@
 #include "track_edit.h"
 
+#include "core/core_string_names.h"
+#include "core/script_language.h"
 #include "core/undo_redo.h"
 #include "scene/animation/animation_player.h"
 #include "scene/main/viewport.h"
@@ -128,6 +130,7 @@ void TrackEdit::_notification(int p_what) {
 
 		type_icon = _get_key_type_icon();
 		selected_icon = _IconsCache::get_singleton()->get_icon("KeySelected");
+		key_index_dirty = true;
 	} break;
 
 	case NOTIFICATION_DRAW: {
@@ -163,17 +166,21 @@ void TrackEdit::_notification(int p_what) {
 
 		// NAMES AND ICONS //
 
-		call(_draw_names_and_icons, limit, font, color, hsep, linecolor);
+		_dispatch_draw_names_and_icons(limit, font, color, hsep, linecolor);
 
 		// KEYFRAMES //
 
-		call(_draw_bg, limit, get_size().width - timeline->get_buttons_width());
+		_dispatch_draw_bg(limit, get_size().width - timeline->get_buttons_width());
 
 		{
 			float scale = timeline->get_zoom_scale();
 			int limit_end = get_size().width - timeline->get_buttons_width();
 
-			for (int i = 0; i < animation->track_get_key_count(track); i++) {
+			int key_from = 0;
+			int key_to = -1;
+			_get_visible_key_range(scale, limit, limit_end, key_from, key_to);
+
+			for (int i = key_from; i <= key_to; i++) {
 				float offset = animation->track_get_key_time(track, i) - timeline->get_value();
 				if (editor->is_key_selected(track, i) && editor->is_moving_selection()) {
 					offset = editor->snap_time(offset + editor->get_moving_selection_offset(), true);
@@ -186,60 +193,21 @@ void TrackEdit::_notification(int p_what) {
 					}
 					offset_n = offset_n * scale + limit;
 
-
-					Variant args[6] = {
-						i,
-						scale,
-						int(offset),
-						int(offset_n),
-						limit,
-						limit_end
-					};
-
-					Variant* argptrs[6] = {
-						&args[0],
-						&args[1],
-						&args[2],
-						&args[3],
-						&args[4],
-						&args[5]
-					};
-					Variant::CallError ce;
-					call(_draw_key_link, (const Variant**)&argptrs, 6, ce);
-
+					_dispatch_draw_key_link(i, scale, int(offset), int(offset_n), limit, limit_end);
 				}
 				else {
-					call(_draw_last_key_link, i, scale, int(offset), limit, limit_end);
+					_dispatch_draw_last_key_link(i, scale, int(offset), limit, limit_end);
 				}
 
-				Variant args[6] = {
-					i,
-					scale,
-					int(offset),
-					editor->is_key_selected(track, i),
-					limit,
-					limit_end
-				};
-
-				Variant* argptrs[6] = {
-					&args[0],
-					&args[1],
-					&args[2],
-					&args[3],
-					&args[4],
-					&args[5]
-				};
-				Variant::CallError ce;
-				call(_draw_key, (const Variant**)&argptrs, 6, ce);
-
+				_dispatch_draw_key(i, scale, int(offset), editor->is_key_selected(track, i), limit, limit_end);
 			}
 		}
 
-		call(_draw_fg, limit, get_size().width - timeline->get_buttons_width());
+		_dispatch_draw_fg(limit, get_size().width - timeline->get_buttons_width());
 
 		// BUTTONS //
 
-		call(_draw_buttons, linecolor);
+		_dispatch_draw_buttons(linecolor);
 
 		if (in_group) {
 			draw_line(Vector2(timeline->get_name_limit(), get_size().height), get_size(), linecolor, Math::round(1.0));
@@ -274,6 +242,39 @@ void TrackEdit::_notification(int p_what) {
 	}
 }
 
+void TrackEdit::_get_visible_key_range(float p_scale, int p_clip_left, int p_clip_right, int& r_from, int& r_to) {
+	r_from = 0;
+	r_to = animation->track_get_key_count(track) - 1;
+	if (r_to < 0 || p_scale <= 0) {
+		return;
+	}
+
+	float time_from = timeline->get_value();
+	float time_to = time_from + (p_clip_right - p_clip_left) / p_scale;
+
+	// Keys outside the range still show when their rect reaches into it, like clips with a length
+	// starting before it or icons centered just past it.
+	_update_key_index();
+	time_from -= key_index_reach_right / p_scale;
+	time_to += key_index_reach_left / p_scale;
+
+	if (editor->is_moving_selection()) {
+		// Selected keys are drawn shifted, so they can come from outside the visible range.
+		float moving_offset = ABS(editor->get_moving_selection_offset());
+		time_from -= moving_offset;
+		time_to += moving_offset;
+	}
+
+	// track_find_key() returns the last key at or before the given time, which is
+	// exactly the leading key needed to draw the link entering the visible range.
+	int first = animation->track_find_key(track, time_from);
+	int last = animation->track_find_key(track, time_to);
+
+	r_from = MAX(first, 0);
+	// One more key past the end so the link leaving the visible range is drawn too.
+	r_to = MIN(last + 1, r_to);
+}
+
 int TrackEdit::get_key_height() const {
 	if (!animation.is_valid()) {
 		return 0;
@@ -294,6 +295,22 @@ Rect2 TrackEdit::get_key_rect(int p_index, float p_pixels_sec) {
 	return rect;
 }
 
+PoolVector2Array TrackEdit::get_key_rects(int p_from_index, int p_to_index, float p_pixels_sec) {
+	PoolVector2Array rects;
+	if (p_to_index < p_from_index) {
+		return rects;
+	}
+
+	rects.resize((p_to_index - p_from_index + 1) * 2);
+	PoolVector2Array::Write w = rects.write();
+	for (int i = p_from_index; i <= p_to_index; i++) {
+		Rect2 rect = _dispatch_get_key_rect(i, p_pixels_sec);
+		w[(i - p_from_index) * 2 + 0] = rect.position;
+		w[(i - p_from_index) * 2 + 1] = rect.size;
+	}
+	return rects;
+}
+
 bool TrackEdit::is_key_selectable_by_distance() const {
 	return true;
 }
@@ -463,13 +480,23 @@ Ref<Animation> TrackEdit::get_animation() const {
 }
 
 void TrackEdit::set_animation_and_track(const Ref<Animation>& p_animation, int p_track) {
+	if (animation.is_valid() && animation->is_connected("changed", this, "_animation_changed")) {
+		animation->disconnect("changed", this, "_animation_changed");
+	}
+
 	animation = p_animation;
 	track = p_track;
+	key_index_dirty = true;
 	update();
 
+	if (animation.is_valid()) {
+		animation->connect("changed", this, "_animation_changed");
+	}
+
 	ERR_FAIL_INDEX(track, animation->get_track_count());
 
 	node_path = animation->track_get_path(p_track);
+	track_type = animation->track_get_type(p_track);
 	type_icon = _get_key_type_icon();
 	selected_icon = _IconsCache::get_singleton()->get_icon("KeySelected");
 }
@@ -480,7 +507,7 @@ Size2 TrackEdit::get_minimum_size() const {
 	int separation = get_constant("vseparation", "ItemList");
 
 	int max_h = MAX((texture != nullptr ? texture->get_height() : 0), font->get_height());
-	int key_height = const_cast<TrackEdit*>(this)->call(_get_key_height);
+	int key_height = const_cast<TrackEdit*>(this)->_dispatch_get_key_height();
 	max_h = MAX(max_h, key_height);
 
 	return Vector2(1, max_h + separation);
@@ -591,115 +618,84 @@ String TrackEdit::get_tooltip(const Point2& p_pos) const {
 		return TTR("Remove this track.");
 	}
 
-	int limit = timeline->get_name_limit();
-	int limit_end = get_size().width - timeline->get_buttons_width();
-	// Left Border including space occupied by keyframes on t=0.
-	int limit_start_hitbox = limit - type_icon->get_width();
-
-	if (p_pos.x >= limit_start_hitbox && p_pos.x <= limit_end) {
-		int key_idx = -1;
-		float key_distance = 1e20;
-
-		// Select should happen in the opposite order of drawing for more accurate overlap select.
-		for (int i = animation->track_get_key_count(track) - 1; i >= 0; i--) {
-			Rect2 rect = const_cast<TrackEdit*>(this)->call(_get_key_rect, i, timeline->get_zoom_scale());
-			float offset = animation->track_get_key_time(track, i) - timeline->get_value();
-			offset = offset * timeline->get_zoom_scale() + limit;
-			rect.position.x += offset;
-
-			if (rect.has_point(p_pos)) {
-				bool key_is_selectable_by_distance = const_cast<TrackEdit*>(this)->call(_is_key_selectable_by_distance);
-				if (key_is_selectable_by_distance) {
-					float distance = ABS(offset - p_pos.x);
-					if (key_idx == -1 || distance < key_distance) {
-						key_idx = i;
-						key_distance = distance;
-					}
-				}
-				else {
-					// First one does it.
-					break;
-				}
-			}
-		}
+	int key_idx = const_cast<TrackEdit*>(this)->_find_key_at_position(p_pos);
 
-		if (key_idx != -1) {
-			String text = "Time (s): " + rtos(animation->track_get_key_time(track, key_idx)) + "\n";
-			switch (animation->track_get_type(track)) {
-			case Animation::TYPE_TRANSFORM: {
-				Dictionary d = animation->track_get_key_value(track, key_idx);
-				if (d.has("location")) {
-					text += "Pos: " + String(d["location"]) + "\n";
-				}
-				if (d.has("rotation")) {
-					text += "Rot: " + String(d["rotation"]) + "\n";
+	if (key_idx != -1) {
+		String text = "Time (s): " + rtos(animation->track_get_key_time(track, key_idx)) + "\n";
+		switch (animation->track_get_type(track)) {
+		case Animation::TYPE_TRANSFORM: {
+			Dictionary d = animation->track_get_key_value(track, key_idx);
+			if (d.has("location")) {
+				text += "Pos: " + String(d["location"]) + "\n";
+			}
+			if (d.has("rotation")) {
+				text += "Rot: " + String(d["rotation"]) + "\n";
+			}
+			if (d.has("scale")) {
+				text += "Scale: " + String(d["scale"]) + "\n";
+			}
+		} break;
+
+		case Animation::TYPE_VALUE: {
+			const Variant& v = animation->track_get_key_value(track, key_idx);
+			text += "Type: " + Variant::get_type_name(v.get_type()) + "\n";
+			Variant::Type valid_type = Variant::NIL;
+			if (!_is_value_key_valid(v, valid_type)) {
+				text += "Value: " + String(v) + "  (Invalid, expected type: " + Variant::get_type_name(valid_type) + ")\n";
+			}
+			else {
+				text += "Value: " + String(v) + "\n";
+			}
+			text += "Easing: " + rtos(animation->track_get_key_transition(track, key_idx));
+
+		} break;
+		case Animation::TYPE_BEZIER: break;
+		case Animation::TYPE_METHOD: {
+			Dictionary d = animation->track_get_key_value(track, key_idx);
+			if (d.has("method")) {
+				text += String(d["method"]);
+			}
+			text += "(";
+			Vector<Variant> args;
+			if (d.has("args")) {
+				args = d["args"];
+			}
+			for (int i = 0; i < args.size(); i++) {
+				if (i > 0) {
+					text += ", ";
 				}
-				if (d.has("scale")) {
-					text += "Scale: " + String(d["scale"]) + "\n";
+				text += String(args[i]);
+			}
+			text += ")\n";
+
+		} break;
+		case Animation::TYPE_AUDIO: {
+			String stream_name = "null";
+			RES stream = animation->audio_track_get_key_stream(track, key_idx);
+			if (stream.is_valid()) {
+				if (stream->get_path().is_resource_file()) {
+					stream_name = stream->get_path().get_file();
 				}
-			} break;
-
-			case Animation::TYPE_VALUE: {
-				const Variant& v = animation->track_get_key_value(track, key_idx);
-				text += "Type: " + Variant::get_type_name(v.get_type()) + "\n";
-				Variant::Type valid_type = Variant::NIL;
-				if (!_is_value_key_valid(v, valid_type)) {
-					text += "Value: " + String(v) + "  (Invalid, expected type: " + Variant::get_type_name(valid_type) + ")\n";
+				else if (!stream->get_name().empty()) {
+					stream_name = stream->get_name();
 				}
 				else {
-					text += "Value: " + String(v) + "\n";
-				}
-				text += "Easing: " + rtos(animation->track_get_key_transition(track, key_idx));
-
-			} break;
-			case Animation::TYPE_BEZIER: break;
-			case Animation::TYPE_METHOD: {
-				Dictionary d = animation->track_get_key_value(track, key_idx);
-				if (d.has("method")) {
-					text += String(d["method"]);
-				}
-				text += "(";
-				Vector<Variant> args;
-				if (d.has("args")) {
-					args = d["args"];
-				}
-				for (int i = 0; i < args.size(); i++) {
-					if (i > 0) {
-						text += ", ";
-					}
-					text += String(args[i]);
-				}
-				text += ")\n";
-
-			} break;
-			case Animation::TYPE_AUDIO: {
-				String stream_name = "null";
-				RES stream = animation->audio_track_get_key_stream(track, key_idx);
-				if (stream.is_valid()) {
-					if (stream->get_path().is_resource_file()) {
-						stream_name = stream->get_path().get_file();
-					}
-					else if (!stream->get_name().empty()) {
-						stream_name = stream->get_name();
-					}
-					else {
-						stream_name = stream->get_class();
-					}
+					stream_name = stream->get_class();
 				}
-
-				text += "Stream: " + stream_name + "\n";
-				float so = animation->audio_track_get_key_start_offset(track, key_idx);
-				text += "Start (s): " + rtos(so) + "\n";
-				float eo = animation->audio_track_get_key_end_offset(track, key_idx);
-				text += "End (s): " + rtos(eo) + "\n";
-			} break;
-			case Animation::TYPE_ANIMATION: {
-				String name = animation->animation_track_get_key_animation(track, key_idx);
-				text += "Animation Clip: " + name + "\n";
-			} break;
 			}
-			return text;
+
+			text += "Stream: " + stream_name + "\n";
+			float so = animation->audio_track_get_key_start_offset(track, key_idx);
+			text += "Start (s): " + rtos(so) + "\n";
+			float eo = animation->audio_track_get_key_end_offset(track, key_idx);
+			text += "End (s): " + rtos(eo) + "\n";
+		} break;
+		case Animation::TYPE_ANIMATION: {
+			String name = animation->animation_track_get_key_animation(track, key_idx);
+			text += "Animation Clip: " + name + "\n";
+		} break;
 		}
+		return text;
 	}
 
 	return Control::get_tooltip(p_pos);
@@ -787,72 +783,41 @@ void TrackEdit::_gui_input(const Ref<InputEvent>& p_event) {
 
 		// Check keyframes.
 
-		float scale = timeline->get_zoom_scale();
 		int limit = timeline->get_name_limit();
-		int limit_end = get_size().width - timeline->get_buttons_width();
-		// Left Border including space occupied by keyframes on t=0.
-		int limit_start_hitbox = limit - type_icon->get_width();
 
-		if (pos.x >= limit_start_hitbox && pos.x <= limit_end) {
-			int key_idx = -1;
-			float key_distance = 1e20;
+		int key_idx = _find_key_at_position(pos);
 
-			// Select should happen in the opposite order of drawing for more accurate overlap select.
-			for (int i = animation->track_get_key_count(track) - 1; i >= 0; i--) {
-				Rect2 rect = call(_get_key_rect, i, scale);
-				float offset = animation->track_get_key_time(track, i) - timeline->get_value();
-				offset = offset * scale + limit;
-				rect.position.x += offset;
-
-				if (rect.has_point(pos)) {
-					bool key_is_selectable_by_distance = call(_is_key_selectable_by_distance);
-					if (key_is_selectable_by_distance) {
-						float distance = ABS(offset - pos.x);
-						if (key_idx == -1 || distance < key_distance) {
-							key_idx = i;
-							key_distance = distance;
-						}
-					}
-					else {
-						// First one does it.
-						key_idx = i;
-						break;
-					}
-				}
-			}
-
-			if (key_idx != -1) {
-				if (mb->get_command() || mb->get_shift()) {
-					if (editor->is_key_selected(track, key_idx)) {
-						emit_signal("deselect_key", key_idx);
-					}
-					else {
-						emit_signal("select_key", key_idx, false);
-						moving_selection_attempt = true;
-						select_single_attempt = -1;
-						moving_selection_from_ofs = (mb->get_position().x - limit) / timeline->get_zoom_scale();
-					}
+		if (key_idx != -1) {
+			if (mb->get_command() || mb->get_shift()) {
+				if (editor->is_key_selected(track, key_idx)) {
+					emit_signal("deselect_key", key_idx);
 				}
 				else {
-					if (!editor->is_key_selected(track, key_idx)) {
-						emit_signal("select_key", key_idx, true);
-						select_single_attempt = -1;
-					}
-					else {
-						select_single_attempt = key_idx;
-					}
-
+					emit_signal("select_key", key_idx, false);
 					moving_selection_attempt = true;
+					select_single_attempt = -1;
 					moving_selection_from_ofs = (mb->get_position().x - limit) / timeline->get_zoom_scale();
 				}
-				accept_event();
 			}
+			else {
+				if (!editor->is_key_selected(track, key_idx)) {
+					emit_signal("select_key", key_idx, true);
+					select_single_attempt = -1;
+				}
+				else {
+					select_single_attempt = key_idx;
+				}
+
+				moving_selection_attempt = true;
+				moving_selection_from_ofs = (mb->get_position().x - limit) / timeline->get_zoom_scale();
+			}
+			accept_event();
 		}
 
 	}
 
 	if (mb.is_valid() && mb->is_pressed() && mb->get_button_index() == BUTTON_RIGHT) {
-		call(_do_right_click, mb);
+		_dispatch_do_right_click(mb);
 	}
 
 	if (mb.is_valid() && moving_selection_attempt) {
@@ -863,16 +828,11 @@ void TrackEdit::_gui_input(const Ref<InputEvent>& p_event) {
 					if(t == get_track()) {
 						continue;
 					}
-					bool track_selected = false;
-					for (int k = 0; k < get_animation()->track_get_key_count(t); ++k) {
-						if(get_editor()->is_key_selected(t, k)) {
-							track_selected = true;
-							break;
-						}
-					}
-					if(track_selected) {
+					if (get_editor()->has_selected_keys(t)) {
 						TrackEdit* target = get_editor()->get_track_edit_for(t);
-						target->emit_signal("move_selection_commit");
+						if (target) {
+							target->emit_signal("move_selection_commit");
+						}
 					}
 				}
 				emit_signal("move_selection_commit");
@@ -892,16 +852,11 @@ void TrackEdit::_gui_input(const Ref<InputEvent>& p_event) {
 				if (t == get_track()) {
 					continue;
 				}
-				bool track_selected = false;
-				for (int k = 0; k < get_animation()->track_get_key_count(t); ++k) {
-					if (get_editor()->is_key_selected(t, k)) {
-						track_selected = true;
-						break;
-					}
-				}
-				if (track_selected) {
+				if (get_editor()->has_selected_keys(t)) {
 					TrackEdit* target = get_editor()->get_track_edit_for(t);
-					target->emit_signal("move_selection_cancel");
+					if (target) {
+						target->emit_signal("move_selection_cancel");
+					}
 				}
 			}
 			emit_signal("move_selection_cancel");
@@ -912,52 +867,14 @@ void TrackEdit::_gui_input(const Ref<InputEvent>& p_event) {
 	if (mm.is_valid()) {
 		const int previous_hovering_key_idx = hovering_key_idx;
 
-		// Hovering compressed keyframes for editing is not possible.
-		const float scale = timeline->get_zoom_scale();
-		const int limit = timeline->get_name_limit();
-		const int limit_end = get_size().width - timeline->get_buttons_width();
-		// Left Border including space occupied by keyframes on t=0.
-		const int limit_start_hitbox = limit - (type_icon == nullptr ? 0 : type_icon->get_width());
+		// Use the same logic as key selection to ensure that hovering accurately represents
+		// which key will be selected when clicking.
 		const Point2 pos = mm->get_position();
+		hovering_key_idx = _find_key_at_position(pos);
 
-		if (pos.x >= limit_start_hitbox && pos.x <= limit_end) {
-			// Use the same logic as key selection to ensure that hovering accurately represents
-			// which key will be selected when clicking.
-			int key_idx = -1;
-			float key_distance = 1e20;
-
-			hovering_key_idx = -1;
-
-			// Hovering should happen in the opposite order of drawing for more accurate overlap hovering.
-			for (int i = animation->track_get_key_count(track) - 1; i >= 0; i--) {
-				Rect2 rect = call(_get_key_rect, i, scale);
-				float offset = animation->track_get_key_time(track, i) - timeline->get_value();
-				offset = offset * scale + limit;
-				rect.position.x += offset;
-
-				if (rect.has_point(pos)) {
-					bool key_is_selectable_by_distance = call(_is_key_selectable_by_distance);
-					if (key_is_selectable_by_distance) {
-						const float distance = ABS(offset - pos.x);
-						if (key_idx == -1 || distance < key_distance) {
-							key_idx = i;
-							key_distance = distance;
-							hovering_key_idx = i;
-						}
-					}
-					else {
-						// First one does it.
-						hovering_key_idx = i;
-						break;
-					}
-				}
-			}
-
-			if (hovering_key_idx != previous_hovering_key_idx) {
-				// Required to draw keyframe hover feedback on the correct keyframe.
-				update();
-			}
-
+		if (hovering_key_idx != previous_hovering_key_idx) {
+			// Required to draw keyframe hover feedback on the correct keyframe.
+			update();
 		}
 	}
 
@@ -968,16 +885,11 @@ void TrackEdit::_gui_input(const Ref<InputEvent>& p_event) {
 				if (t == get_track()) {
 					continue;
 				}
-				bool track_selected = false;
-				for (int k = 0; k < get_animation()->track_get_key_count(t); ++k) {
-					if (get_editor()->is_key_selected(t, k)) {
-						track_selected = true;
-						break;
-					}
-				}
-				if (track_selected) {
+				if (get_editor()->has_selected_keys(t)) {
 					TrackEdit* target = get_editor()->get_track_edit_for(t);
-					target->emit_signal("move_selection_begin");
+					if (target) {
+						target->emit_signal("move_selection_begin");
+					}
 				}
 			}
 			emit_signal("move_selection_begin");
@@ -988,16 +900,11 @@ void TrackEdit::_gui_input(const Ref<InputEvent>& p_event) {
 			if (t == get_track()) {
 				continue;
 			}
-			bool track_selected = false;
-			for (int k = 0; k < get_animation()->track_get_key_count(t); ++k) {
-				if (get_editor()->is_key_selected(t, k)) {
-					track_selected = true;
-					break;
-				}
-			}
-			if (track_selected) {
+			if (get_editor()->has_selected_keys(t)) {
 				TrackEdit* target = get_editor()->get_track_edit_for(t);
-				target->emit_signal("move_selection", new_ofs - moving_selection_from_ofs);
+				if (target) {
+					target->emit_signal("move_selection", new_ofs - moving_selection_from_ofs);
+				}
 			}
 		}
 		emit_signal("move_selection", new_ofs - moving_selection_from_ofs);
@@ -1121,15 +1028,130 @@ void TrackEdit::set_in_group(bool p_enable) {
 	update();
 }
 
+void TrackEdit::_animation_changed() {
+	key_index_dirty = true;
+}
+
+void TrackEdit::invalidate_key_index() {
+	key_index_dirty = true;
+}
+
+void TrackEdit::_update_key_index() {
+	float scale = timeline->get_zoom_scale();
+	float height = get_size().height;
+	if (!key_index_dirty && key_index_scale == scale && key_index_height == height) {
+		return;
+	}
+
+	key_index_dirty = false;
+	key_index_scale = scale;
+	key_index_height = height;
+	key_index.clear();
+	key_index_reach_left = 0;
+	key_index_reach_right = 0;
+
+	int key_count = animation->track_get_key_count(track);
+	_fetch_key_rects(0, key_count - 1, scale, key_index_rects);
+	for (int i = 0; i < key_count; i++) {
+		const Rect2& rect = key_index_rects[i];
+		float time = animation->track_get_key_time(track, i);
+		key_index.add(i, time + rect.position.x / scale, time + (rect.position.x + rect.size.x) / scale);
+		key_index_reach_left = MAX(key_index_reach_left, -rect.position.x);
+		key_index_reach_right = MAX(key_index_reach_right, rect.position.x + rect.size.x);
+	}
+	key_index.build();
+}
+
+void TrackEdit::update_time_range(float p_from, float p_to) {
+	if (animation.is_null() || !is_visible_in_tree()) {
+		return;
+	}
+
+	_update_key_index();
+
+	// Skip the redraw when no key in the range can reach into the visible part of the timeline.
+	float scale = timeline->get_zoom_scale();
+	float view_from = timeline->get_value();
+	float view_to = view_from + (get_size().width - timeline->get_name_limit() - timeline->get_buttons_width()) / scale;
+	if (p_to + key_index_reach_right / scale < view_from || p_from - key_index_reach_left / scale > view_to) {
+		return;
+	}
+
+	update();
+}
+
+void TrackEdit::_query_key_index(float p_from_x, float p_to_x, Vector<int>& r_keys) {
+	_update_key_index();
+
+	float scale = timeline->get_zoom_scale();
+	float from = timeline->get_value() + (p_from_x - timeline->get_name_limit()) / scale;
+	float to = timeline->get_value() + (p_to_x - timeline->get_name_limit()) / scale;
+
+	// Pad by a pixel so rounding never drops a candidate, callers still test the exact rect.
+	key_index.query(from - 1.0 / scale, to + 1.0 / scale, r_keys);
+	r_keys.sort();
+}
+
+int TrackEdit::_find_key_at_position(const Point2& p_pos) {
+	int limit = timeline->get_name_limit();
+	int limit_end = get_size().width - timeline->get_buttons_width();
+	// Left Border including space occupied by keyframes on t=0.
+	int limit_start_hitbox = type_icon.is_valid() ? limit - type_icon->get_width() : limit;
+
+	if (p_pos.x < limit_start_hitbox || p_pos.x > limit_end) {
+		return -1;
+	}
+
+	Vector<int> candidates;
+	_query_key_index(p_pos.x, p_pos.x, candidates);
+	if (candidates.empty()) {
+		return -1;
+	}
+
+	float scale = timeline->get_zoom_scale();
+	bool key_is_selectable_by_distance = _dispatch_is_key_selectable_by_distance();
+	int key_idx = -1;
+	float key_distance = 1e20;
+
+	// Select should happen in the opposite order of drawing for more accurate overlap select.
+	for (int j = candidates.size() - 1; j >= 0; j--) {
+		int i = candidates[j];
+		Rect2 rect = key_index_rects[i];
+		float offset = animation->track_get_key_time(track, i) - timeline->get_value();
+		offset = offset * scale + limit;
+		rect.position.x += offset;
+
+		if (rect.has_point(p_pos)) {
+			if (key_is_selectable_by_distance) {
+				float distance = ABS(offset - p_pos.x);
+				if (key_idx == -1 || distance < key_distance) {
+					key_idx = i;
+					key_distance = distance;
+				}
+			}
+			else {
+				// First one does it.
+				return i;
+			}
+		}
+	}
+
+	return key_idx;
+}
+
 void TrackEdit::append_to_selection(const Rect2& p_box, bool p_deselection) {
 	// Left Border including space occupied by keyframes on t=0.
 	int limit_start_hitbox = timeline->get_name_limit() - type_icon->get_width();
 	Rect2 select_rect(limit_start_hitbox, 0, get_size().width - timeline->get_name_limit() - timeline->get_buttons_width(), get_size().height);
 	select_rect = select_rect.clip(p_box);
 
+	Vector<int> candidates;
+	_query_key_index(select_rect.position.x, select_rect.position.x + select_rect.size.x, candidates);
+
 	// Select should happen in the opposite order of drawing for more accurate overlap select.
-	for (int i = animation->track_get_key_count(track) - 1; i >= 0; i--) {
-		Rect2 rect = call(_get_key_rect, i, timeline->get_zoom_scale());
+	for (int j = candidates.size() - 1; j >= 0; j--) {
+		int i = candidates[j];
+		Rect2 rect = key_index_rects[i];
 		float offset = animation->track_get_key_time(track, i) - timeline->get_value();
 		offset = offset * timeline->get_zoom_scale() + timeline->get_name_limit();
 		rect.position.x += offset;
@@ -1162,6 +1184,196 @@ Rect2 TrackEdit::get_remove_rect() const {
 	return remove_rect;
 }
 
+bool TrackEdit::_is_overridden_by_script(ScriptOverride p_method) const {
+	if (!script_overrides_valid) {
+		// The script changed since the table was built, find which virtuals it overrides.
+		const StringName* methods[OVERRIDE_MAX] = {
+			&_get_key_height,
+			&_get_key_rect,
+			&_get_key_rects,
+			&_is_key_selectable_by_distance,
+			&_draw_key_link,
+			&_draw_last_key_link,
+			&_draw_key,
+			&_draw_bg,
+			&_draw_fg,
+			&_draw_buttons,
+			&_draw_names_and_icons,
+			&_do_right_click
+		};
+
+		ScriptInstance* script_instance = get_script_instance();
+		script_overrides_valid = true;
+		script_overrides = 0;
+		if (script_instance) {
+			for (int i = 0; i < OVERRIDE_MAX; i++) {
+				if (script_instance->has_method(*methods[i])) {
+					script_overrides |= 1 << i;
+				}
+			}
+		}
+	}
+
+	return script_overrides & (1 << p_method);
+}
+
+void TrackEdit::_script_changed() {
+	script_overrides_valid = false;
+}
+
+int TrackEdit::_dispatch_get_key_height() {
+	if (_is_overridden_by_script(OVERRIDE_GET_KEY_HEIGHT)) {
+		return call(_get_key_height);
+	}
+	return get_key_height();
+}
+
+Rect2 TrackEdit::_dispatch_get_key_rect(int p_index, float p_pixels_sec) {
+	if (_is_overridden_by_script(OVERRIDE_GET_KEY_RECT)) {
+		return call(_get_key_rect, p_index, p_pixels_sec);
+	}
+	return get_key_rect(p_index, p_pixels_sec);
+}
+
+void TrackEdit::_fetch_key_rects(int p_from_index, int p_to_index, float p_pixels_sec, Vector<Rect2>& r_rects) {
+	int count = p_to_index - p_from_index + 1;
+	r_rects.resize(MAX(count, 0));
+	if (count <= 0) {
+		return;
+	}
+
+	if (!_is_overridden_by_script(OVERRIDE_GET_KEY_RECTS)) {
+		// Without a batched override every rect still goes through get_key_rect, so skip the pool round trip.
+		for (int i = 0; i < count; i++) {
+			r_rects.write[i] = _dispatch_get_key_rect(p_from_index + i, p_pixels_sec);
+		}
+		return;
+	}
+
+	PoolVector2Array rects = call(_get_key_rects, p_from_index, p_to_index, p_pixels_sec);
+	if (rects.size() != count * 2) {
+		ERR_PRINT("get_key_rects() must return a position and a size for every key in the range, falling back to get_key_rect().");
+		for (int i = 0; i < count; i++) {
+			r_rects.write[i] = _dispatch_get_key_rect(p_from_index + i, p_pixels_sec);
+		}
+		return;
+	}
+
+	PoolVector2Array::Read r = rects.read();
+	for (int i = 0; i < count; i++) {
+		r_rects.write[i] = Rect2(r[i * 2 + 0], r[i * 2 + 1]);
+	}
+}
+
+bool TrackEdit::_dispatch_is_key_selectable_by_distance() {
+	if (_is_overridden_by_script(OVERRIDE_IS_KEY_SELECTABLE_BY_DISTANCE)) {
+		return call(_is_key_selectable_by_distance);
+	}
+	return is_key_selectable_by_distance();
+}
+
+void TrackEdit::_dispatch_draw_key_link(int p_index, float p_pixels_sec, int p_x, int p_next_x, int p_clip_left, int p_clip_right) {
+	if (!_is_overridden_by_script(OVERRIDE_DRAW_KEY_LINK)) {
+		draw_key_link(p_index, p_pixels_sec, p_x, p_next_x, p_clip_left, p_clip_right);
+		return;
+	}
+
+	Variant args[6] = {
+		p_index,
+		p_pixels_sec,
+		p_x,
+		p_next_x,
+		p_clip_left,
+		p_clip_right
+	};
+
+	Variant* argptrs[6] = {
+		&args[0],
+		&args[1],
+		&args[2],
+		&args[3],
+		&args[4],
+		&args[5]
+	};
+	Variant::CallError ce;
+	call(_draw_key_link, (const Variant**)&argptrs, 6, ce);
+}
+
+void TrackEdit::_dispatch_draw_last_key_link(int p_index, float p_pixels_sec, int p_x, int p_clip_left, int p_clip_right) {
+	if (_is_overridden_by_script(OVERRIDE_DRAW_LAST_KEY_LINK)) {
+		call(_draw_last_key_link, p_index, p_pixels_sec, p_x, p_clip_left, p_clip_right);
+		return;
+	}
+	draw_last_key_link(p_index, p_pixels_sec, p_x, p_clip_left, p_clip_right);
+}
+
+void TrackEdit::_dispatch_draw_key(int p_index, float p_pixels_sec, int p_x, bool p_selected, int p_clip_left, int p_clip_right) {
+	if (!_is_overridden_by_script(OVERRIDE_DRAW_KEY)) {
+		draw_key(p_index, p_pixels_sec, p_x, p_selected, p_clip_left, p_clip_right);
+		return;
+	}
+
+	Variant args[6] = {
+		p_index,
+		p_pixels_sec,
+		p_x,
+		p_selected,
+		p_clip_left,
+		p_clip_right
+	};
+
+	Variant* argptrs[6] = {
+		&args[0],
+		&args[1],
+		&args[2],
+		&args[3],
+		&args[4],
+		&args[5]
+	};
+	Variant::CallError ce;
+	call(_draw_key, (const Variant**)&argptrs, 6, ce);
+}
+
+void TrackEdit::_dispatch_draw_bg(int p_clip_left, int p_clip_right) {
+	if (_is_overridden_by_script(OVERRIDE_DRAW_BG)) {
+		call(_draw_bg, p_clip_left, p_clip_right);
+		return;
+	}
+	draw_bg(p_clip_left, p_clip_right);
+}
+
+void TrackEdit::_dispatch_draw_fg(int p_clip_left, int p_clip_right) {
+	if (_is_overridden_by_script(OVERRIDE_DRAW_FG)) {
+		call(_draw_fg, p_clip_left, p_clip_right);
+		return;
+	}
+	draw_fg(p_clip_left, p_clip_right);
+}
+
+void TrackEdit::_dispatch_draw_buttons(Color linecolor) {
+	if (_is_overridden_by_script(OVERRIDE_DRAW_BUTTONS)) {
+		call(_draw_buttons, linecolor);
+		return;
+	}
+	draw_buttons(linecolor);
+}
+
+void TrackEdit::_dispatch_draw_names_and_icons(int limit, const Ref<Font> p_font, Color color, int hsep, Color linecolor) {
+	if (_is_overridden_by_script(OVERRIDE_DRAW_NAMES_AND_ICONS)) {
+		call(_draw_names_and_icons, limit, p_font, color, hsep, linecolor);
+		return;
+	}
+	draw_names_and_icons(limit, p_font, color, hsep, linecolor);
+}
+
+void TrackEdit::_dispatch_do_right_click(Ref<InputEventMouseButton> mb) {
+	if (_is_overridden_by_script(OVERRIDE_DO_RIGHT_CLICK)) {
+		call(_do_right_click, mb);
+		return;
+	}
+	do_right_click(mb);
+}
+
 void TrackEdit::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("do_right_click", "event"), &TrackEdit::do_right_click);
 	ClassDB::bind_method(D_METHOD("get_index_of_track_edit_belonging_to_header", "track"), &TrackEdit::get_index_of_track_edit_belonging_to_header);
@@ -1176,6 +1388,7 @@ void TrackEdit::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("draw_buttons", "linecolor"), &TrackEdit::draw_buttons);
 	ClassDB::bind_method("get_key_height", &TrackEdit::get_key_height);
 	ClassDB::bind_method(D_METHOD("get_key_rect", "index", "pixels_sec"), &TrackEdit::get_key_rect);
+	ClassDB::bind_method(D_METHOD("get_key_rects", "from_index", "to_index", "pixels_sec"), &TrackEdit::get_key_rects);
 	ClassDB::bind_method("is_key_selectable_by_distance", &TrackEdit::is_key_selectable_by_distance);
 	ClassDB::bind_method(D_METHOD("draw_key_link", "index", "pixels_sec", "x", "next_x", "clip_left", "clip_right"), &TrackEdit::draw_key_link);
 	ClassDB::bind_method(D_METHOD("draw_last_key_link", "index", "pixels_sec", "x", "clip_left", "clip_right"), &TrackEdit::draw_last_key_link);
@@ -1185,9 +1398,12 @@ void TrackEdit::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("draw_names_and_icons", "limit", "font", "color", "hsep", "linecolor"), &TrackEdit::draw_names_and_icons);
 
 	ClassDB::bind_method(D_METHOD("_zoom_changed"), &TrackEdit::_zoom_changed);
+	ClassDB::bind_method(D_METHOD("_animation_changed"), &TrackEdit::_animation_changed);
+	ClassDB::bind_method(D_METHOD("invalidate_key_index"), &TrackEdit::invalidate_key_index);
 	ClassDB::bind_method(D_METHOD("_menu_selected"), &TrackEdit::_menu_selected);
 	ClassDB::bind_method(D_METHOD("_play_position_draw"), &TrackEdit::_play_position_draw);
 	ClassDB::bind_method("_icons_cache_changed", &TrackEdit::_icons_cache_changed);
+	ClassDB::bind_method("_script_changed", &TrackEdit::_script_changed);
 	ClassDB::bind_method(D_METHOD("_gui_input", "event"), &TrackEdit::_gui_input);
 
 	ADD_SIGNAL(MethodInfo("timeline_changed", PropertyInfo(Variant::REAL, "position"), PropertyInfo(Variant::BOOL, "drag"), PropertyInfo(Variant::BOOL, "timeline_only")));
@@ -1230,4 +1446,5 @@ TrackEdit::TrackEdit() {
 	set_mouse_filter(MOUSE_FILTER_PASS); // Scroll has to work too for selection.
 
 	_IconsCache::get_singleton()->connect("icons_changed", this, "_icons_cache_changed");
+	connect(CoreStringNames::get_singleton()->script_changed, this, "_script_changed");
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include "scene/gui/control.h"
 #include "scene/resources/animation.h"
 
+#include "key_interval_index.h"
+
 class TimelineEdit;
 class TrackEditor;
 class UndoRedo;
@@ -26,6 +28,7 @@ class TrackEdit : public Control {
 	Control* play_position = nullptr; //separate control used to draw so updates for only position changed are much faster
 	float play_position_pos;
 	NodePath node_path;
+	Animation::TrackType track_type = Animation::TYPE_VALUE;
 
 	Ref<Animation> animation;
 	int track;
@@ -52,6 +55,7 @@ class TrackEdit : public Control {
 	void _menu_selected(int p_index);
 	
 	void _play_position_draw();
+	void _get_visible_key_range(float p_scale, int p_clip_left, int p_clip_right, int& r_from, int& r_to);
 	bool _is_value_key_valid(const Variant& p_key_value, Variant::Type& r_valid_type) const;
 
 	Ref<Texture> _get_key_type_icon() const;
@@ -68,6 +72,59 @@ class TrackEdit : public Control {
 
 	void _icons_cache_changed();
 
+	// Key rects relative to their key, and their extents in time, cached for the zoom scale and height they were built at.
+	KeyIntervalIndex key_index;
+	Vector<Rect2> key_index_rects;
+	float key_index_scale = 0;
+	float key_index_height = 0;
+	bool key_index_dirty = true;
+	// How far key rects reach left and right of their key, in pixels.
+	float key_index_reach_left = 0;
+	float key_index_reach_right = 0;
+
+	void _animation_changed();
+	void _update_key_index();
+	void _query_key_index(float p_from_x, float p_to_x, Vector<int>& r_keys);
+	int _find_key_at_position(const Point2& p_pos);
+
+	// Virtuals a script may override. Native track edits call the C++ virtual directly
+	// instead of paying for a Variant call per key.
+	enum ScriptOverride {
+		OVERRIDE_GET_KEY_HEIGHT,
+		OVERRIDE_GET_KEY_RECT,
+		OVERRIDE_GET_KEY_RECTS,
+		OVERRIDE_IS_KEY_SELECTABLE_BY_DISTANCE,
+		OVERRIDE_DRAW_KEY_LINK,
+		OVERRIDE_DRAW_LAST_KEY_LINK,
+		OVERRIDE_DRAW_KEY,
+		OVERRIDE_DRAW_BG,
+		OVERRIDE_DRAW_FG,
+		OVERRIDE_DRAW_BUTTONS,
+		OVERRIDE_DRAW_NAMES_AND_ICONS,
+		OVERRIDE_DO_RIGHT_CLICK,
+		OVERRIDE_MAX
+	};
+
+	// Rebuilt on first use after the script changes. Hot reloading sets the script again too,
+	// so an instance whose methods changed never keeps the old table.
+	mutable bool script_overrides_valid = false;
+	mutable uint32_t script_overrides = 0;
+	bool _is_overridden_by_script(ScriptOverride p_method) const;
+	void _script_changed();
+
+	int _dispatch_get_key_height();
+	Rect2 _dispatch_get_key_rect(int p_index, float p_pixels_sec);
+	void _fetch_key_rects(int p_from_index, int p_to_index, float p_pixels_sec, Vector<Rect2>& r_rects);
+	bool _dispatch_is_key_selectable_by_distance();
+	void _dispatch_draw_key_link(int p_index, float p_pixels_sec, int p_x, int p_next_x, int p_clip_left, int p_clip_right);
+	void _dispatch_draw_last_key_link(int p_index, float p_pixels_sec, int p_x, int p_clip_left, int p_clip_right);
+	void _dispatch_draw_key(int p_index, float p_pixels_sec, int p_x, bool p_selected, int p_clip_left, int p_clip_right);
+	void _dispatch_draw_bg(int p_clip_left, int p_clip_right);
+	void _dispatch_draw_fg(int p_clip_left, int p_clip_right);
+	void _dispatch_draw_buttons(Color linecolor);
+	void _dispatch_draw_names_and_icons(int limit, const Ref<Font> p_font, Color color, int hsep, Color linecolor);
+	void _dispatch_do_right_click(Ref<InputEventMouseButton> mb);
+
 protected:
 	static void _bind_methods();
 	void _notification(int p_what);
@@ -78,6 +135,7 @@ protected:
 	const StringName _get_tooltip = "get_tooltip";
 	const StringName _get_key_height = "get_key_height";
 	const StringName _get_key_rect = "get_key_rect";
+	const StringName _get_key_rects = "get_key_rects";
 	const StringName _is_key_selectable_by_distance = "is_key_selectable_by_distance";
 	const StringName _draw_key_link = "draw_key_link";
 	const StringName _draw_last_key_link = "draw_last_key_link";
@@ -100,6 +158,8 @@ public:
 
 	virtual int get_key_height() const;
 	virtual Rect2 get_key_rect(int p_index, float p_pixels_sec);
+	// Position and size pairs for the keys in [p_from_index, p_to_index], scripts with many keys should override this.
+	virtual PoolVector2Array get_key_rects(int p_from_index, int p_to_index, float p_pixels_sec);
 	virtual bool is_key_selectable_by_distance() const;
 	virtual void draw_key_link(int p_index, float p_pixels_sec, int p_x, int p_next_x, int p_clip_left, int p_clip_right);
 	virtual void draw_last_key_link(int p_index, float p_pixels_sec, int p_x, int p_clip_left, int p_clip_right);
@@ -118,6 +178,9 @@ public:
 	void draw_rect_clipped(const Rect2& p_rect, const Color& p_color, bool p_filled = true);
 
 	int get_track() const;
+	// Path and type of the track as of the last set_animation_and_track, used to tell whether the track moved.
+	NodePath get_track_path() const { return node_path; }
+	Animation::TrackType get_track_type() const { return track_type; }
 	Ref<Animation> get_animation() const;
 	TimelineEdit* get_timeline() const { return timeline; }
 	TrackEditor* get_editor() const { return editor; }
@@ -136,6 +199,8 @@ public:
 
 	void set_in_group(bool p_enable);
 	void append_to_selection(const Rect2& p_box, bool p_deselection);
+	void invalidate_key_index();
+	void update_time_range(float p_from, float p_to);
 
 
 	TrackEdit();
@@ -7,6 +7,8 @@
 #include "scene/2d/animated_sprite.h"
 
 #include "../editor_consts.h"
+#include "../sfx_gen/sfx_preview.h"
+#include "../sfx_gen/sfx_preview_generator.h"
 
 void TrackEditAudio::_preview_changed(ObjectID p_which) {
 	Object* object = ObjectDB::get_instance(id);
@@ -18,6 +20,7 @@ void TrackEditAudio::_preview_changed(ObjectID p_which) {
 	Ref<AudioStream> stream = object->call("get_stream");
 
 	if (stream.is_valid() && stream->get_instance_id() == p_which) {
+		invalidate_key_index();
 		update();
 	}
 }
@@ -49,8 +52,8 @@ Rect2 TrackEditAudio::get_key_rect(int p_index, float p_pixels_sec) {
 		float len = stream->get_length();
 
 		if (len == 0) {
-			//Ref<AudioStreamPreview> preview = AudioStreamPreviewGenerator::get_singleton()->generate_preview(stream);
-			//len = preview->get_length();
+			Ref<SFXPreview> preview = _SFXPreviewGenerator::get_singleton()->generate_preview(stream);
+			len = preview->get_length();
 		}
 
 		if (get_animation()->track_get_key_count(get_track()) > p_index + 1) {
@@ -89,10 +92,10 @@ void TrackEditAudio::draw_key(int p_index, float p_pixels_sec, int p_x, bool p_s
 	if (play) {
 		float len = stream->get_length();
 
-		//Ref<AudioStreamPreview> preview = AudioStreamPreviewGenerator::get_singleton()->generate_preview(stream);
+		// Generation runs on a thread, until it is done the preview holds silence.
+		Ref<SFXPreview> preview = _SFXPreviewGenerator::get_singleton()->generate_preview(stream);
 
-		//float preview_len = preview->get_length();
-		float preview_len = 0.0;
+		float preview_len = preview->get_length();
 
 		if (len == 0) {
 			len = preview_len;
@@ -124,23 +127,18 @@ void TrackEditAudio::draw_key(int p_index, float p_pixels_sec, int p_x, bool p_s
 			return;
 		}
 
+		drawing_previews.push_back(preview);
+
 		Ref<Font> font = get_font("font", "Label");
 		float fh = int(font->get_height() * 1.5);
 		Rect2 rect = Rect2(from_x, (get_size().height - fh) / 2, to_x - from_x, fh);
 		draw_rect(rect, Color(0.25, 0.25, 0.25));
 
-		Vector<Vector2> lines;
-		lines.resize((to_x - from_x + 1) * 2);
-		//preview_len = preview->get_length();
-
-		for (int i = from_x; i < to_x; i++) {
-			float max = 0.0;// preview->get_max(ofs, ofs_n) * 0.5 + 0.5;
-			float min = 0.0; // preview->get_min(ofs, ofs_n) * 0.5 + 0.5;
+		float ofs_from = (from_x - pixel_begin) * preview_len / pixel_len;
+		float ofs_to = (to_x - pixel_begin) * preview_len / pixel_len;
 
-			int idx = i - from_x;
-			lines.write[idx * 2 + 0] = Vector2(i, rect.position.y + min * rect.size.y);
-			lines.write[idx * 2 + 1] = Vector2(i, rect.position.y + max * rect.size.y);
-		}
+		Vector<Vector2> lines;
+		preview->fill_waveform_lines(ofs_from, ofs_to, rect, lines);
 
 		Vector<Color> color;
 		color.push_back(Color(0.75, 0.75, 0.75));
@@ -167,14 +165,29 @@ void TrackEditAudio::draw_key(int p_index, float p_pixels_sec, int p_x, bool p_s
 	}
 }
 
+void TrackEditAudio::_notification(int p_what) {
+	switch (p_what) {
+	case NOTIFICATION_DRAW: {
+		// Runs after TrackEdit drew the keys.
+		drawn_previews = drawing_previews;
+		drawing_previews.clear();
+	} break;
+	case NOTIFICATION_EXIT_TREE: {
+		drawing_previews.clear();
+		drawn_previews.clear();
+	} break;
+	}
+}
+
 void TrackEditAudio::set_node(Object* p_object) {
 	id = p_object->get_instance_id();
 }
 
 void TrackEditAudio::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("_gui_input", "event"), &TrackEdit::_gui_input);
+	ClassDB::bind_method("_preview_changed", &TrackEditAudio::_preview_changed);
 }
 
 TrackEditAudio::TrackEditAudio() {
-	//AudioStreamPreviewGenerator::get_singleton()->connect("preview_updated", this, "_preview_changed");
+	_SFXPreviewGenerator::get_singleton()->connect("preview_updated", this, "_preview_changed");
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define TRACK_EDIT_AUDIO_H
 
 #include "track_edit.h"
+#include "../sfx_gen/sfx_preview.h"
 
 class TrackEditAudio : public TrackEdit {
 	GDCLASS(TrackEditAudio, TrackEdit);
@@ -10,8 +11,14 @@ class TrackEditAudio : public TrackEdit {
 
 	void _preview_changed(ObjectID p_which);
 
+	// Previews of the clips on screen, held so the generator doesn't evict them. drawing_previews
+	// fills up while keys are drawn and replaces drawn_previews once the whole track is.
+	Vector<Ref<SFXPreview>> drawing_previews;
+	Vector<Ref<SFXPreview>> drawn_previews;
+
 protected:
 	static void _bind_methods();
+	void _notification(int p_what);
 
 public:
 	virtual int get_key_height() const override;
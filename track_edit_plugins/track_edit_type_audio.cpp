@@ -9,11 +9,15 @@
 #include "scene/2d/animated_sprite.h"
 
 #include "../editor_consts.h"
+#include "../sfx_gen/sfx_preview.h"
+#include "../sfx_gen/sfx_preview_generator.h"
 
 void TrackEditTypeAudio::_preview_changed(ObjectID p_which) {
 	for (int i = 0; i < get_animation()->track_get_key_count(get_track()); i++) {
 		Ref<AudioStream> stream = get_animation()->audio_track_get_key_stream(get_track(), i);
 		if (stream.is_valid() && stream->get_instance_id() == p_which) {
+			// Streams without a length take it from the preview, so the clip extents may change too.
+			invalidate_key_index();
 			update();
 			return;
 		}
@@ -38,8 +42,8 @@ Rect2 TrackEditTypeAudio::get_key_rect(int p_index, float p_pixels_sec) {
 	float len = stream->get_length();
 
 	if (len == 0) {
-		//Ref<AudioStreamPreview> preview = AudioStreamPreviewGenerator::get_singleton()->generate_preview(stream);
-		//len = preview->get_length();
+		Ref<SFXPreview> preview = _SFXPreviewGenerator::get_singleton()->generate_preview(stream);
+		len = preview->get_length();
 	}
 
 	len -= end_ofs;
@@ -91,15 +95,19 @@ void TrackEditTypeAudio::draw_key(int p_index, float p_pixels_sec, int p_x, bool
 
 	float len = stream->get_length();
 
-	//Ref<AudioStreamPreview> preview = AudioStreamPreviewGenerator::get_singleton()->generate_preview(stream);
+	// Generation runs on a thread, until it is done the preview holds silence.
+	Ref<SFXPreview> preview = _SFXPreviewGenerator::get_singleton()->generate_preview(stream);
 
-	float preview_len = 0.0; // preview->get_length();
+	float preview_len = preview->get_length();
 
 	if (len == 0) {
 		len = preview_len;
 	}
 
 	int pixel_total_len = len * p_pixels_sec;
+	if (pixel_total_len <= 0) {
+		pixel_total_len = 1;
+	}
 
 	len -= end_ofs;
 	len -= start_ofs;
@@ -134,27 +142,17 @@ void TrackEditTypeAudio::draw_key(int p_index, float p_pixels_sec, int p_x, bool
 		to_x = from_x + 1;
 	}
 
+	drawing_previews.push_back(preview);
+
 	int h = get_size().height;
 	Rect2 rect = Rect2(from_x, (h - fh) / 2, to_x - from_x, fh);
 	draw_rect(rect, Color(0.25, 0.25, 0.25));
 
-	Vector<Vector2> lines;
-	lines.resize((to_x - from_x + 1) * 2);
-	//preview_len = preview->get_length();
-
-	for (int i = from_x; i < to_x; i++) {
-		float ofs = (i - pixel_begin) * preview_len / pixel_total_len;
-		float ofs_n = ((i + 1) - pixel_begin) * preview_len / pixel_total_len;
-		ofs += start_ofs;
-		ofs_n += start_ofs;
-
-		float max = 0.0; // preview->get_max(ofs, ofs_n) * 0.5 + 0.5;
-		float min = 0.0; // preview->get_min(ofs, ofs_n) * 0.5 + 0.5;
+	float ofs_from = start_ofs + (from_x - pixel_begin) * preview_len / pixel_total_len;
+	float ofs_to = start_ofs + (to_x - pixel_begin) * preview_len / pixel_total_len;
 
-		int idx = i - from_x;
-		lines.write[idx * 2 + 0] = Vector2(i, rect.position.y + min * rect.size.y);
-		lines.write[idx * 2 + 1] = Vector2(i, rect.position.y + max * rect.size.y);
-	}
+	Vector<Vector2> lines;
+	preview->fill_waveform_lines(ofs_from, ofs_to, rect, lines);
 
 	Vector<Color> color;
 	color.push_back(Color(0.75, 0.75, 0.75));
@@ -176,11 +174,26 @@ void TrackEditTypeAudio::draw_key(int p_index, float p_pixels_sec, int p_x, bool
 	}
 }
 
+void TrackEditTypeAudio::_notification(int p_what) {
+	switch (p_what) {
+	case NOTIFICATION_DRAW: {
+		// Runs after TrackEdit drew the keys.
+		drawn_previews = drawing_previews;
+		drawing_previews.clear();
+	} break;
+	case NOTIFICATION_EXIT_TREE: {
+		drawing_previews.clear();
+		drawn_previews.clear();
+	} break;
+	}
+}
+
 void TrackEditTypeAudio::_bind_methods() {
+	ClassDB::bind_method("_preview_changed", &TrackEditTypeAudio::_preview_changed);
 }
 
 TrackEditTypeAudio::TrackEditTypeAudio() {
-	//AudioStreamPreviewGenerator::get_singleton()->connect("preview_updated", this, "_preview_changed");
+	_SFXPreviewGenerator::get_singleton()->connect("preview_updated", this, "_preview_changed");
 	len_resizing = false;
 }
 
@@ -268,9 +281,8 @@ void TrackEditTypeAudio::_gui_input(const Ref<InputEvent>& p_event) {
 			float len = stream->get_length();
 
 			if (len == 0) {
-				//Ref<AudioStreamPreview> preview = AudioStreamPreviewGenerator::get_singleton()->generate_preview(stream);
-				//float preview_len = preview->get_length();
-				len = 0.0; //preview_len;
+				Ref<SFXPreview> preview = _SFXPreviewGenerator::get_singleton()->generate_preview(stream);
+				len = preview->get_length();
 			}
 
 			len -= end_ofs;
@@ -2,12 +2,18 @@
 #define TRACK_EDIT_TYPE_AUDIO_H
 
 #include "track_edit.h"
+#include "../sfx_gen/sfx_preview.h"
 
 class TrackEditTypeAudio : public TrackEdit {
 	GDCLASS(TrackEditTypeAudio, TrackEdit);
 
 	void _preview_changed(ObjectID p_which);
 
+	// Previews of the clips on screen, held so the generator doesn't evict them. drawing_previews
+	// fills up while keys are drawn and replaces drawn_previews once the whole track is.
+	Vector<Ref<SFXPreview>> drawing_previews;
+	Vector<Ref<SFXPreview>> drawn_previews;
+
 	bool len_resizing = false;
 	bool len_resizing_start;
 	int len_resizing_index;
@@ -17,6 +23,7 @@ class TrackEditTypeAudio : public TrackEdit {
 
 protected:
 	static void _bind_methods();
+	void _notification(int p_what);
 
 public:
 	void _gui_input(const Ref<InputEvent>& p_event);
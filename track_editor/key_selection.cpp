@@ -0,0 +1,75 @@
+#include "key_selection.h"
+
+bool KeySelection::has(int p_track, int p_key) const {
+	return keys.has(_make_id(p_track, p_key));
+}
+
+void KeySelection::insert(int p_track, int p_key, float p_pos) {
+	uint64_t id = _make_id(p_track, p_key);
+	float* pos = keys.getptr(id);
+	if (pos) {
+		*pos = p_pos;
+		return;
+	}
+
+	keys.set(id, p_pos);
+	int* count = track_counts.getptr(p_track);
+	if (count) {
+		(*count)++;
+	}
+	else {
+		track_counts.set(p_track, 1);
+	}
+}
+
+void KeySelection::erase(int p_track, int p_key) {
+	if (!keys.erase(_make_id(p_track, p_key))) {
+		return;
+	}
+
+	int* count = track_counts.getptr(p_track);
+	ERR_FAIL_COND(!count);
+	if (--(*count) == 0) {
+		track_counts.erase(p_track);
+	}
+}
+
+void KeySelection::clear() {
+	keys.clear();
+	track_counts.clear();
+}
+
+bool KeySelection::has_track(int p_track) const {
+	return track_counts.has(p_track);
+}
+
+int KeySelection::get_track_key_count(int p_track) const {
+	const int* count = track_counts.getptr(p_track);
+	return count ? *count : 0;
+}
+
+Vector<int> KeySelection::get_tracks() const {
+	Vector<int> tracks;
+	const int* track = nullptr;
+	while ((track = track_counts.next(track))) {
+		tracks.push_back(*track);
+	}
+	return tracks;
+}
+
+Vector<KeySelection::SelectedKey> KeySelection::get_sorted() const {
+	Vector<SelectedKey> sorted;
+	sorted.resize(keys.size());
+
+	int i = 0;
+	const uint64_t* id = nullptr;
+	while ((id = keys.next(id))) {
+		SelectedKey& sk = sorted.write[i++];
+		sk.track = int(uint32_t(*id >> 32));
+		sk.key = int(uint32_t(*id & 0xFFFFFFFF));
+		sk.pos = keys[*id];
+	}
+
+	sorted.sort();
+	return sorted;
+}
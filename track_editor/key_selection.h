@@ -0,0 +1,41 @@
+#ifndef KEY_SELECTION_H
+#define KEY_SELECTION_H
+
+#include "core/hash_map.h"
+#include "core/vector.h"
+
+// Selected keys of an animation, hashed by track and key index so membership and
+// "does this track have a selection" are O(1) lookups.
+class KeySelection {
+public:
+	struct SelectedKey {
+		int track = 0;
+		int key = 0;
+		float pos = 0;
+		bool operator<(const SelectedKey& p_key) const { return track == p_key.track ? key < p_key.key : track < p_key.track; };
+	};
+
+private:
+	HashMap<uint64_t, float> keys;
+	HashMap<int, int> track_counts;
+
+	static _FORCE_INLINE_ uint64_t _make_id(int p_track, int p_key) { return (uint64_t(uint32_t(p_track)) << 32) | uint32_t(p_key); }
+
+public:
+	bool has(int p_track, int p_key) const;
+	void insert(int p_track, int p_key, float p_pos);
+	void erase(int p_track, int p_key);
+	void clear();
+
+	int size() const { return keys.size(); }
+	bool empty() const { return keys.empty(); }
+
+	bool has_track(int p_track) const;
+	int get_track_key_count(int p_track) const;
+	Vector<int> get_tracks() const;
+
+	// Selected keys ordered by track then key, operations that remove keys by index walk it backwards.
+	Vector<SelectedKey> get_sorted() const;
+};
+
+#endif
@@ -42,7 +42,7 @@ void TrackEditor::set_animation(const Ref<Animation>& p_anim) {
 	animation = p_anim;
 	timeline->set_animation(p_anim);
 
-	_update_tracks();
+	_rebuild_tracks();
 
 	if (animation.is_valid()) {
 		animation->connect("changed", this, "_animation_changed");
@@ -103,7 +103,7 @@ void TrackEditor::set_root(Node* p_root) {
 		root->connect("tree_exiting", this, "_root_removed", make_binds(), CONNECT_ONESHOT);
 	}
 
-	_update_tracks();
+	_rebuild_tracks();
 }
 
 Node* TrackEditor::get_root() const {
@@ -181,23 +181,84 @@ void TrackEditor::cleanup() {
 }
 
 TrackEdit* TrackEditor::get_track_edit_for(int p_track) const {
-	for(int i=0; i<track_edits.size(); ++i) {
-		if(track_edits[i]->get_track() == p_track) {
-			return track_edits[i];
-		}
+	if (p_track < 0 || p_track >= track_edits.size()) {
+		return nullptr;
 	}
-	return nullptr;
+	return track_edits[p_track];
 }
 
-void TrackEditor::_name_limit_changed() {
+void TrackEditor::_update_track_edits() {
 	for (int i = 0; i < track_edits.size(); i++) {
-		track_edits[i]->update();
+		if (track_edits[i]) {
+			track_edits[i]->update();
+		}
 	}
-	for(int i=0; i<track_edit_headers.size(); ++i) {
+	for (int i = 0; i < track_edit_headers.size(); i++) {
 		track_edit_headers[i]->update();
 	}
 }
 
+void TrackEditor::_mark_track_dirty(int p_track) {
+	_mark_track_dirty(p_track, -Math_INF, Math_INF);
+}
+
+void TrackEditor::_mark_track_dirty(int p_track, float p_from, float p_to) {
+	Map<int, Vector2>::Element* E = dirty_tracks.find(p_track);
+	if (E) {
+		E->get().x = MIN(E->get().x, p_from);
+		E->get().y = MAX(E->get().y, p_to);
+	}
+	else {
+		dirty_tracks.insert(p_track, Vector2(p_from, p_to));
+	}
+}
+
+void TrackEditor::_mark_selection_dirty() {
+	const Vector<KeySelection::SelectedKey> keys = selection.get_sorted();
+	for (int i = 0; i < keys.size(); i++) {
+		_mark_track_dirty(keys[i].track, keys[i].pos, keys[i].pos);
+	}
+}
+
+void TrackEditor::_mark_selected_tracks_dirty() {
+	// Moving keys shifts every selected key of a track, and the links between them.
+	const Vector<int> tracks = selection.get_tracks();
+	for (int i = 0; i < tracks.size(); i++) {
+		_mark_track_dirty(tracks[i]);
+	}
+}
+
+void TrackEditor::_queue_dirty_tracks_flush() {
+	if (dirty_tracks_flush_queued) {
+		return;
+	}
+	dirty_tracks_flush_queued = true;
+	call_deferred("_flush_dirty_tracks");
+}
+
+void TrackEditor::_flush_dirty_tracks() {
+	dirty_tracks_flush_queued = false;
+
+	if (all_tracks_dirty) {
+		_update_track_edits();
+	}
+	else {
+		for (Map<int, Vector2>::Element* E = dirty_tracks.front(); E; E = E->next()) {
+			TrackEdit* te = get_track_edit_for(E->key());
+			if (te) {
+				te->update_time_range(E->get().x, E->get().y);
+			}
+		}
+	}
+
+	all_tracks_dirty = false;
+	dirty_tracks.clear();
+}
+
+void TrackEditor::_name_limit_changed() {
+	_update_track_edits();
+}
+
 void TrackEditor::_timeline_changed(float p_new_pos, bool p_drag, bool p_timeline_only) {
 	emit_signal("timeline_changed", p_new_pos, p_drag, p_timeline_only);
 }
@@ -243,7 +304,9 @@ void TrackEditor::_track_grab_focus(int p_track) {
 void TrackEditor::set_anim_pos(float p_pos) {
 	timeline->set_play_position(p_pos);
 	for (int i = 0; i < track_edits.size(); i++) {
-		track_edits[i]->set_play_position(p_pos);
+		if (track_edits[i]) {
+			track_edits[i]->set_play_position(p_pos);
+		}
 	}
 	for(int i=0; i< track_edit_headers.size(); ++i) {
 		track_edit_headers[i]->set_play_position(p_pos);
@@ -885,24 +948,22 @@ void TrackEditor::set_empty_state_text(String p_text) {
 }
 
 bool TrackEditor::is_key_selected(int p_track, int p_key) const {
-	SelectedKey sk;
-	sk.key = p_key;
-	sk.track = p_track;
+	return selection.has(p_track, p_key);
+}
 
-	return selection.has(sk);
+bool TrackEditor::has_selected_keys(int p_track) const {
+	return selection.has_track(p_track);
 }
 
 bool TrackEditor::is_selection_active() const {
-	return selection.size();
+	return !selection.empty();
 }
 
 bool TrackEditor::is_snap_enabled() const {
 	return snap->is_pressed() ^ Input::get_singleton()->is_key_pressed(KEY_CONTROL);
 }
 
-void TrackEditor::_update_tracks() {
-	int selected = _get_track_selected();
-
+void TrackEditor::_clear_track_edits() {
 	while (track_vbox->get_child_count()) {
 		Node *child = track_vbox->get_child(0);
 		track_vbox->remove_child(child);
@@ -910,15 +971,84 @@ void TrackEditor::_update_tracks() {
 	}
 
 	track_edits.clear();
+	track_edit_keys.clear();
 	track_edit_headers.clear();
+	track_rows.clear();
+	track_edit_pool.clear();
+	rows_top_spacer = nullptr;
+	rows_bottom_spacer = nullptr;
+}
 
+void TrackEditor::_rebuild_tracks() {
+	_clear_track_edits();
+	_update_tracks();
+}
+
+String TrackEditor::_get_track_edit_key(int p_track, const Ref<Script>& p_script) const {
+	String key = itos(animation->track_get_type(p_track)) + ":" + String(animation->track_get_path(p_track));
+	if (p_script.is_valid()) {
+		key += ":" + itos(p_script->get_instance_id());
+	}
+	return key;
+}
+
+TrackEdit* TrackEditor::_take_reusable_track_edit(Map<String, List<TrackEdit*>>& r_reusable, const String& p_key, int p_track) {
+	Map<String, List<TrackEdit*>>::Element* E = r_reusable.find(p_key);
+	if (!E || E->get().empty()) {
+		return nullptr;
+	}
+
+	TrackEdit* track_edit = E->get().front()->get();
+	E->get().pop_front();
+
+	track_edits.write[p_track] = track_edit;
+	if (track_edit->get_track() != p_track) {
+		_connect_track_index_signals(track_edit, p_track);
+	}
+	track_edit->set_animation_and_track(animation, p_track);
+	return track_edit;
+}
+
+void TrackEditor::_update_tracks() {
 	if (animation.is_null()) {
+		_clear_track_edits();
 		return;
 	}
 
+	if (virtualize_tracks) {
+		_update_track_rows();
+		return;
+	}
+
+	int selected = _get_track_selected();
+
+	// Existing edits are reused for tracks with the same type, path and group script,
+	// only tracks that were added or changed get a new edit.
+	Map<String, List<TrackEdit*>> reusable;
+	for (int i = 0; i < track_edits.size(); i++) {
+		if (track_edits[i]) {
+			reusable[track_edit_keys[i]].push_back(track_edits[i]);
+		}
+	}
+
+	Vector<TrackEdit*> reusable_headers = track_edit_headers;
+	track_edit_headers.clear();
+
 	track_edits.resize(animation->get_track_count());
+	track_edit_keys.resize(animation->get_track_count());
+	for (int i = 0; i < track_edits.size(); i++) {
+		track_edits.write[i] = nullptr;
+		track_edit_keys.write[i] = String();
+	}
+
+	// Order the edits should end up in inside track_vbox.
+	Vector<TrackEdit*> order;
 
-	Vector<int> completed_tracks;
+	Vector<bool> completed_tracks;
+	completed_tracks.resize(animation->get_track_count());
+	for (int i = 0; i < completed_tracks.size(); i++) {
+		completed_tracks.write[i] = false;
+	}
 
 	Map<String, VBoxContainer*> group_sort;
 
@@ -926,44 +1056,67 @@ void TrackEditor::_update_tracks() {
 
 	for (Map<Ref<Script>, Vector<Ref<Script>>>::Element* E = track_edit_groups.front(); E; E = E->next()) {
 		Ref<Script> track_header_class = E->key();
-		TrackEdit* track_edit_header = memnew(TrackEdit);
-		ScriptInstance* track_edit_header_script_instance = track_header_class->instance_create(track_edit_header);
-		if (track_edit_header_script_instance) {
-			track_edit_header->set_script_instance(track_edit_header_script_instance);
-			add_track_edit(track_edit_header, 0, true);
+		TrackEdit* track_edit_header = nullptr;
+		for (int i = 0; i < reusable_headers.size(); i++) {
+			ScriptInstance* script_instance = reusable_headers[i]->get_script_instance();
+			if (script_instance && script_instance->get_script() == track_header_class) {
+				track_edit_header = reusable_headers[i];
+				reusable_headers.remove(i);
+				break;
+			}
+		}
+
+		if (track_edit_header) {
+			track_edit_headers.push_back(track_edit_header);
+			track_edit_header->set_animation_and_track(animation, 0);
 		}
 		else {
-			memdelete(track_edit_header);
-			continue;
+			track_edit_header = memnew(TrackEdit);
+			ScriptInstance* track_edit_header_script_instance = track_header_class->instance_create(track_edit_header);
+			if (track_edit_header_script_instance) {
+				track_edit_header->set_script_instance(track_edit_header_script_instance);
+				add_track_edit(track_edit_header, 0, true);
+			}
+			else {
+				memdelete(track_edit_header);
+				continue;
+			}
 		}
+		order.push_back(track_edit_header);
 
 		for (int i = 0; i < animation->get_track_count(); i++) {
 			const int track_edit_index = track_edit_header->call(_get_index_of_track_edit_belonging_to_header, i);
 			if (track_edit_index > -1) {
 				Vector<Ref<Script>> track_edit_scripts = E->value();
 				Ref<Script> track_edit_script = track_edit_scripts[track_edit_index];
-				TrackEdit* track_edit = memnew(TrackEdit);
-				ScriptInstance* track_edit_script_instance = track_edit_script->instance_create(track_edit);
+				String key = _get_track_edit_key(i, track_edit_script);
 
-				if (track_edit_script_instance) {
-					track_edit->set_script_instance(track_edit_script_instance);
-					add_track_edit(track_edit, i, false);
-					completed_tracks.push_back(i);
-				}
-				else {
-					memdelete(track_edit);
+				TrackEdit* track_edit = _take_reusable_track_edit(reusable, key, i);
+				if (!track_edit) {
+					track_edit = memnew(TrackEdit);
+					ScriptInstance* track_edit_script_instance = track_edit_script->instance_create(track_edit);
+
+					if (track_edit_script_instance) {
+						track_edit->set_script_instance(track_edit_script_instance);
+						add_track_edit(track_edit, i, false);
+					}
+					else {
+						memdelete(track_edit);
+						continue;
+					}
 				}
+
+				track_edit_keys.write[i] = key;
+				order.push_back(track_edit);
+				completed_tracks.write[i] = true;
 			}
 		}
 	}
 	
 	for (int i = 0; i < animation->get_track_count(); i++) {
-		if (completed_tracks.find(i) > -1) {
+		if (completed_tracks[i]) {
 			continue;
 		}
-		TrackEdit* track_edit = nullptr;
-
-		// Find hint and info for plugin.
 
 		if (use_filter) {
 			NodePath path = animation->track_get_path(i);
@@ -979,74 +1132,459 @@ void TrackEditor::_update_tracks() {
 			}
 		}
 
-		if (animation->track_get_type(i) == Animation::TYPE_VALUE) {
-			NodePath path = animation->track_get_path(i);
+		String key = _get_track_edit_key(i, Ref<Script>());
+		TrackEdit* track_edit = _take_reusable_track_edit(reusable, key, i);
 
-			if (root && root->has_node_and_resource(path)) {
-				RES res;
-				NodePath base_path;
-				Vector<StringName> leftover_path;
-				Node* node = root->get_node_and_resource(path, res, leftover_path, true);
-				PropertyInfo pinfo = _find_hint_for_track(i, base_path);
+		if (!track_edit) {
+			track_edit = _create_track_edit(i);
+			add_track_edit(track_edit, i, false);
+		}
 
-				Object* object = node;
-				if (res.is_valid()) {
-					object = res.ptr();
-				}
+		track_edit_keys.write[i] = key;
+		order.push_back(track_edit);
+		if (selected == i) {
+			track_edit->grab_focus();
+		}
+	}
 
-				if (object && !leftover_path.empty()) {
-					if (pinfo.name.empty()) {
-						pinfo.name = leftover_path[leftover_path.size() - 1];
-					}
+	// Whatever was not reused belongs to tracks that are gone.
+	for (Map<String, List<TrackEdit*>>::Element* E = reusable.front(); E; E = E->next()) {
+		for (List<TrackEdit*>::Element* F = E->get().front(); F; F = F->next()) {
+			track_vbox->remove_child(F->get());
+			F->get()->queue_delete();
+		}
+	}
+	for (int i = 0; i < reusable_headers.size(); i++) {
+		track_vbox->remove_child(reusable_headers[i]);
+		reusable_headers[i]->queue_delete();
+	}
+
+	// New edits were appended, only the ones out of place need moving.
+	for (int i = 0; i < order.size(); i++) {
+		if (order[i]->get_index() != i) {
+			track_vbox->move_child(order[i], i);
+		}
+	}
+}
+
+TrackEdit* TrackEditor::_create_track_edit(int p_track) {
+	TrackEdit* track_edit = _create_plugin_track_edit(p_track);
+
+	if (track_edit == nullptr) {
+		// No valid plugin_found.
+		track_edit = memnew(TrackEdit);
+	}
+
+	return track_edit;
+}
+
+TrackEdit* TrackEditor::_create_plugin_track_edit(int p_track) {
+	TrackEdit* track_edit = nullptr;
+
+	// Find hint and info for plugin.
 
-					for (int j = 0; j < track_edit_plugins.size(); j++) {
-						track_edit = track_edit_plugins.write[j]->create_value_track_edit(object, pinfo.type, pinfo.name, pinfo.hint, pinfo.hint_string, pinfo.usage);
-						if (track_edit) {
-							break;
-						}
+	if (animation->track_get_type(p_track) == Animation::TYPE_VALUE) {
+		NodePath path = animation->track_get_path(p_track);
+
+		if (root && root->has_node_and_resource(path)) {
+			RES res;
+			NodePath base_path;
+			Vector<StringName> leftover_path;
+			Node* node = root->get_node_and_resource(path, res, leftover_path, true);
+			PropertyInfo pinfo = _find_hint_for_track(p_track, base_path);
+
+			Object* object = node;
+			if (res.is_valid()) {
+				object = res.ptr();
+			}
+
+			if (object && !leftover_path.empty()) {
+				if (pinfo.name.empty()) {
+					pinfo.name = leftover_path[leftover_path.size() - 1];
+				}
+
+				for (int j = 0; j < track_edit_plugins.size(); j++) {
+					track_edit = track_edit_plugins.write[j]->create_value_track_edit(object, pinfo.type, pinfo.name, pinfo.hint, pinfo.hint_string, pinfo.usage);
+					if (track_edit) {
+						break;
 					}
 				}
 			}
 		}
-		if (animation->track_get_type(i) == Animation::TYPE_AUDIO) {
+	}
+	if (animation->track_get_type(p_track) == Animation::TYPE_AUDIO) {
+		for (int j = 0; j < track_edit_plugins.size(); j++) {
+			track_edit = track_edit_plugins.write[j]->create_audio_track_edit();
+			if (track_edit) {
+				break;
+			}
+		}
+	}
+
+	if (animation->track_get_type(p_track) == Animation::TYPE_ANIMATION) {
+		NodePath path = animation->track_get_path(p_track);
+
+		Node* node = nullptr;
+		if (root && root->has_node(path)) {
+			node = root->get_node(path);
+		}
+
+		if (node && Object::cast_to<AnimationPlayer>(node)) {
 			for (int j = 0; j < track_edit_plugins.size(); j++) {
-				track_edit = track_edit_plugins.write[j]->create_audio_track_edit();
+				track_edit = track_edit_plugins.write[j]->create_animation_track_edit(node);
 				if (track_edit) {
 					break;
 				}
 			}
 		}
+	}
+
+	return track_edit;
+}
+
+bool TrackEditor::_is_plain_track_edit(TrackEdit* p_track_edit) {
+	return p_track_edit->get_script_instance() == nullptr && p_track_edit->get_class() == "TrackEdit";
+}
+
+void TrackEditor::_update_track_rows() {
+	// Edits of rows that were on screen are handed back to the rows with the same key.
+	Map<String, List<TrackEdit*>> reusable;
+	for (int i = 0; i < track_rows.size(); i++) {
+		if (track_rows[i].track >= 0 && track_rows[i].track_edit) {
+			reusable[track_rows[i].key].push_back(track_rows[i].track_edit);
+		}
+	}
+
+	Vector<TrackEdit*> reusable_headers = track_edit_headers;
+	track_edit_headers.clear();
+
+	track_rows.clear();
+	track_edits.resize(animation->get_track_count());
+	track_edit_keys.resize(animation->get_track_count());
+	for (int i = 0; i < track_edits.size(); i++) {
+		track_edits.write[i] = nullptr;
+		track_edit_keys.write[i] = String();
+	}
+
+	if (!rows_top_spacer) {
+		rows_top_spacer = memnew(Control);
+		rows_top_spacer->set_mouse_filter(MOUSE_FILTER_IGNORE);
+		track_vbox->add_child(rows_top_spacer);
+		rows_bottom_spacer = memnew(Control);
+		rows_bottom_spacer->set_mouse_filter(MOUSE_FILTER_IGNORE);
+		track_vbox->add_child(rows_bottom_spacer);
+	}
+
+	Vector<bool> completed_tracks;
+	completed_tracks.resize(animation->get_track_count());
+	for (int i = 0; i < completed_tracks.size(); i++) {
+		completed_tracks.write[i] = false;
+	}
+
+	bool use_filter = selected_filter->is_pressed();
+
+	for (Map<Ref<Script>, Vector<Ref<Script>>>::Element* E = track_edit_groups.front(); E; E = E->next()) {
+		Ref<Script> track_header_class = E->key();
+		TrackEdit* track_edit_header = nullptr;
+		for (int i = 0; i < reusable_headers.size(); i++) {
+			ScriptInstance* script_instance = reusable_headers[i]->get_script_instance();
+			if (script_instance && script_instance->get_script() == track_header_class) {
+				track_edit_header = reusable_headers[i];
+				reusable_headers.remove(i);
+				break;
+			}
+		}
+
+		if (track_edit_header) {
+			track_edit_headers.push_back(track_edit_header);
+			track_edit_header->set_animation_and_track(animation, 0);
+		}
+		else {
+			track_edit_header = memnew(TrackEdit);
+			ScriptInstance* track_edit_header_script_instance = track_header_class->instance_create(track_edit_header);
+			if (track_edit_header_script_instance) {
+				track_edit_header->set_script_instance(track_edit_header_script_instance);
+				add_track_edit(track_edit_header, 0, true);
+			}
+			else {
+				memdelete(track_edit_header);
+				continue;
+			}
+		}
 
-		if (animation->track_get_type(i) == Animation::TYPE_ANIMATION) {
+		// Headers always exist since they decide which tracks they own, off screen they are just hidden.
+		track_edit_header->hide();
+		TrackRow header_row;
+		header_row.header = track_edit_header;
+		track_rows.push_back(header_row);
+
+		for (int i = 0; i < animation->get_track_count(); i++) {
+			const int track_edit_index = track_edit_header->call(_get_index_of_track_edit_belonging_to_header, i);
+			if (track_edit_index > -1) {
+				Vector<Ref<Script>> track_edit_scripts = E->value();
+				TrackRow row;
+				row.track = i;
+				row.script = track_edit_scripts[track_edit_index];
+				row.key = _get_track_edit_key(i, row.script);
+				row.path = animation->track_get_path(i);
+				row.type = animation->track_get_type(i);
+				track_rows.push_back(row);
+				track_edit_keys.write[i] = row.key;
+				completed_tracks.write[i] = true;
+			}
+		}
+	}
+
+	for (int i = 0; i < animation->get_track_count(); i++) {
+		if (completed_tracks[i]) {
+			continue;
+		}
+
+		if (use_filter) {
 			NodePath path = animation->track_get_path(i);
 
-			Node* node = nullptr;
 			if (root && root->has_node(path)) {
-				node = root->get_node(path);
+				Node* node = root->get_node(path);
+				if (!node) {
+					continue; // No node, no filter.
+				}
 			}
+		}
 
-			if (node && Object::cast_to<AnimationPlayer>(node)) {
-				for (int j = 0; j < track_edit_plugins.size(); j++) {
-					track_edit = track_edit_plugins.write[j]->create_animation_track_edit(node);
-					if (track_edit) {
-						break;
-					}
-				}
+		TrackRow row;
+		row.track = i;
+		row.key = _get_track_edit_key(i, Ref<Script>());
+		row.path = animation->track_get_path(i);
+		row.type = animation->track_get_type(i);
+		track_rows.push_back(row);
+		track_edit_keys.write[i] = row.key;
+	}
+
+	for (int i = 0; i < reusable_headers.size(); i++) {
+		track_vbox->remove_child(reusable_headers[i]);
+		reusable_headers[i]->queue_delete();
+	}
+
+	_bind_visible_rows(&reusable);
+
+	// Whatever was not reused belongs to tracks that are gone or off screen.
+	for (Map<String, List<TrackEdit*>>::Element* E = reusable.front(); E; E = E->next()) {
+		for (List<TrackEdit*>::Element* F = E->get().front(); F; F = F->next()) {
+			_recycle_track_edit(F->get());
+		}
+	}
+}
+
+void TrackEditor::_recycle_track_edit(TrackEdit* p_track_edit) {
+	if (p_track_edit->has_focus()) {
+		p_track_edit->release_focus();
+	}
+
+	if (_is_plain_track_edit(p_track_edit)) {
+		p_track_edit->hide();
+		track_edit_pool.push_back(p_track_edit);
+	}
+	else {
+		track_vbox->remove_child(p_track_edit);
+		p_track_edit->queue_delete();
+	}
+}
+
+void TrackEditor::_bind_track_row(int p_row, Map<String, List<TrackEdit*>>* r_reusable) {
+	TrackRow& row = track_rows.write[p_row];
+	if (row.track < 0) {
+		row.header->show();
+		row.height = row.header->get_combined_minimum_size().height;
+		return;
+	}
+
+	TrackEdit* track_edit = nullptr;
+	if (r_reusable) {
+		Map<String, List<TrackEdit*>>::Element* E = r_reusable->find(row.key);
+		if (E && !E->get().empty()) {
+			track_edit = E->get().front()->get();
+			E->get().pop_front();
+			if (track_edit->get_track() != row.track) {
+				_connect_track_index_signals(track_edit, row.track);
 			}
+			track_edit->set_animation_and_track(animation, row.track);
+			track_edits.write[row.track] = track_edit;
 		}
+	}
 
-		if (track_edit == nullptr) {
-			// No valid plugin_found.
+	if (!track_edit && row.script.is_valid()) {
+		track_edit = memnew(TrackEdit);
+		ScriptInstance* track_edit_script_instance = row.script->instance_create(track_edit);
+		if (track_edit_script_instance) {
+			track_edit->set_script_instance(track_edit_script_instance);
+			add_track_edit(track_edit, row.track, false);
+		}
+		else {
+			memdelete(track_edit);
+			track_edit = nullptr;
+		}
+	}
+
+	if (!track_edit && !row.plain) {
+		track_edit = _create_plugin_track_edit(row.track);
+		if (track_edit) {
+			add_track_edit(track_edit, row.track, false);
+		}
+		else {
+			// Remember it, so scrolling back to this row skips probing the plugins.
+			row.plain = true;
+		}
+	}
+
+	if (!track_edit) {
+		if (track_edit_pool.size()) {
+			track_edit = track_edit_pool[track_edit_pool.size() - 1];
+			track_edit_pool.remove(track_edit_pool.size() - 1);
+			_connect_track_index_signals(track_edit, row.track);
+			track_edit->set_animation_and_track(animation, row.track);
+			track_edit->set_play_position(timeline->get_play_position());
+			track_edits.write[row.track] = track_edit;
+		}
+		else {
 			track_edit = memnew(TrackEdit);
+			add_track_edit(track_edit, row.track, false);
 		}
+	}
 
-		add_track_edit(track_edit, i, false);
-		if (selected == i) {
-			track_edit->grab_focus();
+	track_edit->show();
+	row.track_edit = track_edit;
+	row.height = track_edit->get_combined_minimum_size().height;
+}
+
+void TrackEditor::_release_track_row(int p_row) {
+	TrackRow& row = track_rows.write[p_row];
+	if (row.track < 0) {
+		row.header->hide();
+		return;
+	}
+
+	if (!row.track_edit) {
+		return;
+	}
+
+	track_edits.write[row.track] = nullptr;
+	_recycle_track_edit(row.track_edit);
+	row.track_edit = nullptr;
+}
+
+void TrackEditor::_queue_visible_rows_update() {
+	if (!virtualize_tracks || visible_rows_update_queued) {
+		return;
+	}
+	visible_rows_update_queued = true;
+	call_deferred("_update_visible_rows");
+}
+
+void TrackEditor::_update_visible_rows() {
+	_bind_visible_rows(nullptr);
+}
+
+void TrackEditor::_bind_visible_rows(Map<String, List<TrackEdit*>>* r_reusable) {
+	visible_rows_update_queued = false;
+	if (!virtualize_tracks || !rows_top_spacer) {
+		return;
+	}
+
+	if (track_rows.empty()) {
+		rows_top_spacer->hide();
+		rows_bottom_spacer->hide();
+		return;
+	}
+
+	// Row heights are estimated until a row has been on screen once, measure one row to have an estimate.
+	if (default_row_height <= 0) {
+		for (int i = 0; i < track_rows.size(); i++) {
+			if (track_rows[i].track >= 0) {
+				_bind_track_row(i, r_reusable);
+				default_row_height = MAX(track_rows[i].height, 1.0f);
+				break;
+			}
+		}
+		if (default_row_height <= 0) {
+			default_row_height = 1;
 		}
+	}
+
+	int separation = track_vbox->get_constant("separation");
+	float view_from = scroll->get_v_scroll() - default_row_height * VISIBLE_ROWS_MARGIN;
+	float view_to = scroll->get_v_scroll() + scroll->get_size().height + default_row_height * VISIBLE_ROWS_MARGIN;
+
+	int first = -1;
+	int last = -1;
+	float first_y = 0;
+	float last_end = 0;
+	float total = 0;
+	for (int i = 0; i < track_rows.size(); i++) {
+		float height = track_rows[i].height > 0 ? track_rows[i].height : default_row_height;
+		if (first == -1 && total + height >= view_from) {
+			first = i;
+			first_y = total;
+		}
+		if (total <= view_to) {
+			last = i;
+			last_end = total + height;
+		}
+		total += height + separation;
+	}
+	total -= separation;
+
+	if (first == -1) {
+		// Scrolled past the end, which happens while rows shrink; keep the last one bound.
+		first = track_rows.size() - 1;
+		last = first;
+		first_y = total - (track_rows[first].height > 0 ? track_rows[first].height : default_row_height);
+		last_end = total;
+	}
+
+	for (int i = 0; i < track_rows.size(); i++) {
+		if (i < first || i > last) {
+			_release_track_row(i);
+		}
+	}
+
+	Vector<Control*> order;
+	order.push_back(rows_top_spacer);
+	for (int i = first; i <= last; i++) {
+		if (track_rows[i].track < 0 ? !track_rows[i].header->is_visible() : !track_rows[i].track_edit) {
+			_bind_track_row(i, r_reusable);
+		}
+		order.push_back(track_rows[i].track < 0 ? track_rows[i].header : track_rows[i].track_edit);
+	}
+	order.push_back(rows_bottom_spacer);
 
+	// Spacers stand in for the rows that are not instantiated, so the scroll range stays right.
+	rows_top_spacer->set_visible(first > 0);
+	rows_top_spacer->set_custom_minimum_size(Size2(0, MAX(first_y - separation, 0.0f)));
+	rows_bottom_spacer->set_visible(last < track_rows.size() - 1);
+	rows_bottom_spacer->set_custom_minimum_size(Size2(0, MAX(total - last_end - separation, 0.0f)));
 
+	for (int i = 0; i < order.size(); i++) {
+		if (order[i]->get_index() != i) {
+			track_vbox->move_child(order[i], i);
+		}
+	}
+}
+
+void TrackEditor::_track_rows_scrolled(double) {
+	_queue_visible_rows_update();
+}
+
+void TrackEditor::set_virtualize_tracks(bool p_enable) {
+	if (virtualize_tracks == p_enable) {
+		return;
 	}
+
+	virtualize_tracks = p_enable;
+	_rebuild_tracks();
+}
+
+bool TrackEditor::is_virtualizing_tracks() const {
+	return virtualize_tracks;
 }
 
 void TrackEditor::set_track_edit_type(const Ref<Script> &p_header_class, const Array &p_track_edit_classes) {
@@ -1082,9 +1620,7 @@ void TrackEditor::add_track_edit(TrackEdit* p_track_edit, int p_track, bool p_is
 	if (!p_is_header) {
 		p_track_edit->connect("remove_request", this, "_track_remove_request", varray(), CONNECT_DEFERRED);
 		p_track_edit->connect("dropped", this, "_dropped_track", varray(), CONNECT_DEFERRED);
-		p_track_edit->connect("insert_key", this, "_insert_key_from_track", varray(p_track), CONNECT_DEFERRED);
-		p_track_edit->connect("select_key", this, "_key_selected", varray(p_track), CONNECT_DEFERRED);
-		p_track_edit->connect("deselect_key", this, "_key_deselected", varray(p_track), CONNECT_DEFERRED);
+		_connect_track_index_signals(p_track_edit, p_track);
 		p_track_edit->connect("move_selection_begin", this, "_move_selection_begin");
 		p_track_edit->connect("move_selection", this, "_move_selection");
 		p_track_edit->connect("move_selection_commit", this, "_move_selection_commit");
@@ -1096,16 +1632,36 @@ void TrackEditor::add_track_edit(TrackEdit* p_track_edit, int p_track, bool p_is
 	}
 }
 
-void TrackEditor::_animation_changed() {
-	if (animation_changing_awaiting_update) {
-		return; // All will be updated, don't bother with anything.
+void TrackEditor::_connect_track_index_signals(TrackEdit* p_track_edit, int p_track) {
+	// These carry the track index as a bind, so they are reconnected when the edit moves to another track.
+	if (p_track_edit->is_connected("insert_key", this, "_insert_key_from_track")) {
+		p_track_edit->disconnect("insert_key", this, "_insert_key_from_track");
+		p_track_edit->disconnect("select_key", this, "_key_selected");
+		p_track_edit->disconnect("deselect_key", this, "_key_deselected");
 	}
 
+	p_track_edit->connect("insert_key", this, "_insert_key_from_track", varray(p_track), CONNECT_DEFERRED);
+	p_track_edit->connect("select_key", this, "_key_selected", varray(p_track), CONNECT_DEFERRED);
+	p_track_edit->connect("deselect_key", this, "_key_deselected", varray(p_track), CONNECT_DEFERRED);
+}
+
+void TrackEditor::_animation_changed() {
 	if (key_edit && key_edit->setting) {
 		// If editing a key, just update the edited track, makes refresh less costly.
-		if (key_edit->track < track_edits.size()) {
-			track_edits[key_edit->track]->update();
-		}
+		_mark_track_dirty(key_edit->track);
+		_queue_dirty_tracks_flush();
+		return;
+	}
+
+	if (applying_keys_track >= 0) {
+		_mark_track_dirty(applying_keys_track);
+	}
+	else {
+		// Nothing tells which tracks an outside change touched.
+		animation_change_unknown = true;
+	}
+
+	if (animation_changing_awaiting_update) {
 		return;
 	}
 
@@ -1156,27 +1712,40 @@ void TrackEditor::_animation_update() {
 		// Check tracks are the same.
 
 		for (int i = 0; i < track_edits.size(); i++) {
-			if (track_edits[i]->get_path() != animation->track_get_path(i)) {
+			if (!track_edits[i]) {
+				continue;
+			}
+			if (track_edits[i]->get_track_path() != animation->track_get_path(i) || track_edits[i]->get_track_type() != animation->track_get_type(i)) {
 				same = false;
 				break;
 			}
 		}
+
+		// Virtualized rows without an edit still know which track they were built for.
+		for (int i = 0; i < track_rows.size() && same; i++) {
+			const TrackRow& row = track_rows[i];
+			if (row.track >= 0 && (row.path != animation->track_get_path(row.track) || row.type != animation->track_get_type(row.track))) {
+				same = false;
+			}
+		}
 	}
 	else {
 		same = false;
 	}
 
 	if (same) {
-		for (int i = 0; i < track_edits.size(); i++) {
-			track_edits[i]->update();
-		}
-		for (int i = 0; i < track_edit_headers.size(); i++) {
-			track_edit_headers[i]->update();
+		if (animation_change_unknown) {
+			all_tracks_dirty = true;
 		}
+		_flush_dirty_tracks();
 	}
 	else {
+		// Rebuilt rows redraw anyway, and the dirty indices may point to other tracks now.
+		dirty_tracks.clear();
+		all_tracks_dirty = false;
 		_update_tracks();
 	}
+	animation_change_unknown = false;
 
 	_update_step_spinbox();
 	emit_signal("animation_step_changed", animation->get_step());
@@ -1211,12 +1780,7 @@ void TrackEditor::_notification(int p_what) {
 }
 
 void TrackEditor::_update_scroll(double) {
-	for (int i = 0; i < track_edits.size(); i++) {
-		track_edits[i]->update();
-	}
-	for (int i = 0; i < track_edit_headers.size(); i++) {
-		track_edit_headers[i]->update();
-	}
+	_update_track_edits();
 }
 
 void TrackEditor::_update_step(double p_new_step) {
@@ -1382,8 +1946,10 @@ void TrackEditor::_timeline_value_changed(double) {
 	timeline->update_play_position();
 
 	for (int i = 0; i < track_edits.size(); i++) {
-		track_edits[i]->update();
-		track_edits[i]->update_play_position();
+		if (track_edits[i]) {
+			track_edits[i]->update();
+			track_edits[i]->update_play_position();
+		}
 	}
 	for (int i = 0; i < track_edit_headers.size(); i++) {
 		track_edit_headers[i]->update();
@@ -1393,7 +1959,7 @@ void TrackEditor::_timeline_value_changed(double) {
 
 int TrackEditor::_get_track_selected() {
 	for (int i = 0; i < track_edits.size(); i++) {
-		if (track_edits[i]->has_focus()) {
+		if (track_edits[i] && track_edits[i]->has_focus()) {
 			return i;
 		}
 	}
@@ -1502,24 +2068,15 @@ void TrackEditor::_key_selected(int p_key, bool p_single, int p_track) {
 	ERR_FAIL_INDEX(p_track, animation->get_track_count());
 	ERR_FAIL_INDEX(p_key, animation->track_get_key_count(p_track));
 
-	SelectedKey sk;
-	sk.key = p_key;
-	sk.track = p_track;
-
 	if (p_single) {
 		_clear_selection();
 	}
 
-	KeyInfo ki;
-	ki.pos = animation->track_get_key_time(p_track, p_key);
-	selection[sk] = ki;
+	float pos = animation->track_get_key_time(p_track, p_key);
+	selection.insert(p_track, p_key, pos);
 
-	for (int i = 0; i < track_edits.size(); i++) {
-		track_edits[i]->update();
-	}
-	for (int i = 0; i < track_edit_headers.size(); i++) {
-		track_edit_headers[i]->update();
-	}
+	_mark_track_dirty(p_track, pos, pos);
+	_queue_dirty_tracks_flush();
 
 	_update_key_edit();
 }
@@ -1528,18 +2085,11 @@ void TrackEditor::_key_deselected(int p_key, int p_track) {
 	ERR_FAIL_INDEX(p_track, animation->get_track_count());
 	ERR_FAIL_INDEX(p_key, animation->track_get_key_count(p_track));
 
-	SelectedKey sk;
-	sk.key = p_key;
-	sk.track = p_track;
+	selection.erase(p_track, p_key);
 
-	selection.erase(sk);
-
-	for (int i = 0; i < track_edits.size(); i++) {
-		track_edits[i]->update();
-	}
-	for (int i = 0; i < track_edit_headers.size(); i++) {
-		track_edit_headers[i]->update();
-	}
+	float pos = animation->track_get_key_time(p_track, p_key);
+	_mark_track_dirty(p_track, pos, pos);
+	_queue_dirty_tracks_flush();
 
 	_update_key_edit();
 }
@@ -1550,23 +2100,178 @@ void TrackEditor::_move_selection_begin() {
 }
 
 void TrackEditor::_move_selection(float p_offset) {
+	// Every track edit holding selected keys reports the same motion.
+	if (p_offset == moving_selection_offset) {
+		return;
+	}
 	moving_selection_offset = p_offset;
 
-	for (int i = 0; i < track_edits.size(); i++) {
-		track_edits[i]->update();
-	}
-	for (int i = 0; i < track_edit_headers.size(); i++) {
-		track_edit_headers[i]->update();
-	}
+	_mark_selected_tracks_dirty();
+	_queue_dirty_tracks_flush();
 }
 
-struct _AnimMoveRestore {
-	int track = 0;
+struct _AnimKey {
 	float time = 0;
-	Variant key;
 	float transition = 0;
+	Variant value;
+	int order = 0;
+};
+
+struct _AnimKeyCompare {
+	_FORCE_INLINE_ bool operator()(const _AnimKey& p_a, const _AnimKey& p_b) const {
+		return p_a.time == p_b.time ? p_a.order < p_b.order : p_a.time < p_b.time;
+	}
 };
-// Used for undo/redo.
+
+Dictionary TrackEditor::_get_track_keys(int p_track) const {
+	int key_count = animation->track_get_key_count(p_track);
+
+	PoolRealArray times;
+	PoolRealArray transitions;
+	Array values;
+	times.resize(key_count);
+	transitions.resize(key_count);
+	values.resize(key_count);
+
+	{
+		PoolRealArray::Write wt = times.write();
+		PoolRealArray::Write wtr = transitions.write();
+		for (int i = 0; i < key_count; i++) {
+			wt[i] = animation->track_get_key_time(p_track, i);
+			wtr[i] = animation->track_get_key_transition(p_track, i);
+			values[i] = animation->track_get_key_value(p_track, i);
+		}
+	}
+
+	Dictionary keys;
+	keys["times"] = times;
+	keys["transitions"] = transitions;
+	keys["values"] = values;
+	return keys;
+}
+
+void TrackEditor::_apply_track_keys(const Ref<Animation>& p_anim, int p_track, const Dictionary& p_keys) {
+	ERR_FAIL_COND(p_anim.is_null());
+	ERR_FAIL_INDEX(p_track, p_anim->get_track_count());
+
+	PoolRealArray times = p_keys["times"];
+	PoolRealArray transitions = p_keys["transitions"];
+	Array values = p_keys["values"];
+	ERR_FAIL_COND(times.size() != transitions.size() || times.size() != values.size());
+
+	// Every removed and inserted key would emit changed, notify once for the whole block instead.
+	bool was_blocking_signals = p_anim->is_blocking_signals();
+	p_anim->set_block_signals(true);
+
+	// Removing from the back and inserting in time order keeps both loops linear.
+	for (int i = p_anim->track_get_key_count(p_track) - 1; i >= 0; i--) {
+		p_anim->track_remove_key(p_track, i);
+	}
+
+	PoolRealArray::Read rt = times.read();
+	PoolRealArray::Read rtr = transitions.read();
+	for (int i = 0; i < times.size(); i++) {
+		p_anim->track_insert_key(p_track, rt[i], values[i], rtr[i]);
+	}
+
+	p_anim->set_block_signals(was_blocking_signals);
+
+	if (p_anim == animation) {
+		applying_keys_track = p_track;
+	}
+	p_anim->emit_signal("changed");
+	applying_keys_track = -1;
+}
+
+void TrackEditor::_add_key_blocks_undo(const Vector<KeySelection::SelectedKey>& p_keys, const Vector<float>& p_new_times) {
+	// Keys are sorted by track, every run of the same track becomes one block.
+	int from = 0;
+	while (from < p_keys.size()) {
+		int track = p_keys[from].track;
+		int to = from;
+		while (to < p_keys.size() && p_keys[to].track == track) {
+			to++;
+		}
+
+		Dictionary before = _get_track_keys(track);
+		PoolRealArray times = before["times"];
+		PoolRealArray transitions = before["transitions"];
+		Array values = before["values"];
+
+		// Selected keys are pulled out, everything else stays where it is.
+		Vector<_AnimKey> kept;
+		Vector<_AnimKey> moved;
+		{
+			PoolRealArray::Read rt = times.read();
+			PoolRealArray::Read rtr = transitions.read();
+			int selected = from;
+			for (int i = 0; i < times.size(); i++) {
+				_AnimKey key;
+				key.time = rt[i];
+				key.transition = rtr[i];
+				key.value = values[i];
+				if (selected < to && p_keys[selected].key == i) {
+					selected++;
+					continue;
+				}
+				kept.push_back(key);
+			}
+
+			// Inserted from the last key to the first, a key inserted later replaces one at the same time.
+			if (p_new_times.size()) {
+				for (int i = to - 1; i >= from; i--) {
+					_AnimKey key;
+					key.time = p_new_times[i];
+					key.transition = rtr[p_keys[i].key];
+					key.value = values[p_keys[i].key];
+					key.order = to - 1 - i;
+					moved.push_back(key);
+				}
+				moved.sort_custom<_AnimKeyCompare>();
+			}
+		}
+
+		PoolRealArray new_times;
+		PoolRealArray new_transitions;
+		Array new_values;
+		int k = 0;
+		int m = 0;
+		while (k < kept.size() || m < moved.size()) {
+			const _AnimKey* key;
+			if (m < moved.size()) {
+				// Only the last of several moved keys landing on the same time survives. Times are compared
+				// the way Animation finds keys, so the result never holds two keys it considers the same.
+				while (m + 1 < moved.size() && Math::is_equal_approx(moved[m + 1].time, moved[m].time)) {
+					m++;
+				}
+				while (k < kept.size() && Math::is_equal_approx(kept[k].time, moved[m].time)) {
+					k++; // Overlapped by a moved key.
+				}
+			}
+
+			if (m >= moved.size() || (k < kept.size() && kept[k].time < moved[m].time)) {
+				key = &kept[k++];
+			}
+			else {
+				key = &moved[m++];
+			}
+
+			new_times.push_back(key->time);
+			new_transitions.push_back(key->transition);
+			new_values.push_back(key->value);
+		}
+
+		Dictionary after;
+		after["times"] = new_times;
+		after["transitions"] = new_transitions;
+		after["values"] = new_values;
+
+		undo_redo->add_do_method(this, "_apply_track_keys", animation, track, after);
+		undo_redo->add_undo_method(this, "_apply_track_keys", animation, track, before);
+
+		from = to;
+	}
+}
 
 void TrackEditor::_clear_key_edit() {
 	if (key_edit) {
@@ -1591,15 +2296,11 @@ void TrackEditor::_clear_key_edit() {
 }
 
 void TrackEditor::_clear_selection(bool p_update) {
+	_mark_selection_dirty();
 	selection.clear();
 
 	if (p_update) {
-		for (int i = 0; i < track_edits.size(); i++) {
-			track_edits[i]->update();
-		}
-		for (int i = 0; i < track_edit_headers.size(); i++) {
-			track_edit_headers[i]->update();
-		}
+		_queue_dirty_tracks_flush();
 	}
 
 	_clear_key_edit();
@@ -1612,12 +2313,13 @@ void TrackEditor::_update_key_edit() {
 	}
 
 	if (selection.size() == 1) {
+		const KeySelection::SelectedKey sk = selection.get_sorted()[0];
 		key_edit = memnew(TrackKeyEdit);
 		key_edit->animation = animation;
-		key_edit->track = selection.front()->key().track;
+		key_edit->track = sk.track;
 		key_edit->use_fps = timeline->is_using_fps();
 
-		float ofs = animation->track_get_key_time(key_edit->track, selection.front()->key().key);
+		float ofs = animation->track_get_key_time(key_edit->track, sk.key);
 		key_edit->key_ofs = ofs;
 		key_edit->root_path = root;
 
@@ -1635,8 +2337,9 @@ void TrackEditor::_update_key_edit() {
 		Map<int, List<float>> key_ofs_map;
 		Map<int, NodePath> base_map;
 		int first_track = -1;
-		for (Map<SelectedKey, KeyInfo>::Element* E = selection.front(); E; E = E->next()) {
-			int track = E->key().track;
+		const Vector<KeySelection::SelectedKey> keys = selection.get_sorted();
+		for (int i = 0; i < keys.size(); i++) {
+			int track = keys[i].track;
 			if (first_track < 0) {
 				first_track = track;
 			}
@@ -1646,7 +2349,7 @@ void TrackEditor::_update_key_edit() {
 				base_map[track] = NodePath();
 			}
 
-			key_ofs_map[track].push_back(animation->track_get_key_time(track, E->key().key));
+			key_ofs_map[track].push_back(animation->track_get_key_time(track, keys[i].key));
 		}
 		multi_key_edit->key_ofs_map = key_ofs_map;
 		multi_key_edit->base_map = base_map;
@@ -1678,105 +2381,69 @@ void TrackEditor::_select_at_anim(const Ref<Animation>& p_anim, int p_track, flo
 	int idx = animation->track_find_key(p_track, p_pos, true);
 	ERR_FAIL_COND(idx < 0);
 
-	SelectedKey sk;
-	sk.track = p_track;
-	sk.key = idx;
-	KeyInfo ki;
-	ki.pos = p_pos;
-
-	selection.insert(sk, ki);
+	selection.insert(p_track, idx, p_pos);
+	_mark_track_dirty(p_track, p_pos, p_pos);
+	_queue_dirty_tracks_flush();
 }
 
-void TrackEditor::_move_selection_commit() {
-	undo_redo->create_action(TTR("Anim Move Keys"));
-
-	List<_AnimMoveRestore> to_restore;
-
-	float motion = moving_selection_offset;
-	// 1 - remove the keys.
-	for (Map<SelectedKey, KeyInfo>::Element* E = selection.back(); E; E = E->prev()) {
-		undo_redo->add_do_method(animation.ptr(), "track_remove_key", E->key().track, E->key().key);
-	}
-	// 2 - Remove overlapped keys.
-	for (Map<SelectedKey, KeyInfo>::Element* E = selection.back(); E; E = E->prev()) {
-		float newtime = snap_time(E->get().pos + motion);
-		int idx = animation->track_find_key(E->key().track, newtime, true);
-		if (idx == -1) {
-			continue;
-		}
-		SelectedKey sk;
-		sk.key = idx;
-		sk.track = E->key().track;
-		if (selection.has(sk)) {
-			continue; // Already in selection, don't save.
-		}
-
-		undo_redo->add_do_method(animation.ptr(), "track_remove_key_at_time", E->key().track, newtime);
-		_AnimMoveRestore amr;
-
-		amr.key = animation->track_get_key_value(E->key().track, idx);
-		amr.track = E->key().track;
-		amr.time = newtime;
-		amr.transition = animation->track_get_key_transition(E->key().track, idx);
-
-		to_restore.push_back(amr);
+void TrackEditor::_select_keys_at_anim(const Ref<Animation>& p_anim, const PoolIntArray& p_tracks, const PoolRealArray& p_times) {
+	if (animation != p_anim) {
+		return;
 	}
 
-	// 3 - Move the keys (Reinsert them).
-	for (Map<SelectedKey, KeyInfo>::Element* E = selection.back(); E; E = E->prev()) {
-		float newpos = snap_time(E->get().pos + motion);
-		undo_redo->add_do_method(animation.ptr(), "track_insert_key", E->key().track, newpos, animation->track_get_key_value(E->key().track, E->key().key), animation->track_get_key_transition(E->key().track, E->key().key));
-	}
+	ERR_FAIL_COND(p_tracks.size() != p_times.size());
 
-	// 4 - (Undo) Remove inserted keys.
-	for (Map<SelectedKey, KeyInfo>::Element* E = selection.back(); E; E = E->prev()) {
-		float newpos = snap_time(E->get().pos + motion);
-		undo_redo->add_undo_method(animation.ptr(), "track_remove_key_at_time", E->key().track, newpos);
-	}
+	_clear_selection();
 
-	// 5 - (Undo) Reinsert keys.
-	for (Map<SelectedKey, KeyInfo>::Element* E = selection.back(); E; E = E->prev()) {
-		undo_redo->add_undo_method(animation.ptr(), "track_insert_key", E->key().track, E->get().pos, animation->track_get_key_value(E->key().track, E->key().key), animation->track_get_key_transition(E->key().track, E->key().key));
+	PoolIntArray::Read rtk = p_tracks.read();
+	PoolRealArray::Read rt = p_times.read();
+	for (int i = 0; i < p_tracks.size(); i++) {
+		int idx = animation->track_find_key(rtk[i], rt[i], true);
+		ERR_CONTINUE(idx < 0);
+		selection.insert(rtk[i], idx, rt[i]);
+		_mark_track_dirty(rtk[i], rt[i], rt[i]);
 	}
+	_queue_dirty_tracks_flush();
+}
 
-	// 6 - (Undo) Reinsert overlapped keys.
-	for (List<_AnimMoveRestore>::Element* amr = to_restore.front(); amr; amr = amr->next()) {
-		undo_redo->add_undo_method(animation.ptr(), "track_insert_key", amr->get().track, amr->get().time, amr->get().key, amr->get().transition);
+void TrackEditor::_move_selection_commit() {
+	// Every track edit holding selected keys emits the commit, only the first one counts.
+	if (!moving_selection) {
+		return;
 	}
 
-	undo_redo->add_do_method(this, "_clear_selection_for_anim", animation);
-	undo_redo->add_undo_method(this, "_clear_selection_for_anim", animation);
-
-	// 7 - Reselect.
-	for (Map<SelectedKey, KeyInfo>::Element* E = selection.back(); E; E = E->prev()) {
-		float oldpos = E->get().pos;
-		float newpos = snap_time(oldpos + motion);
+	const Vector<KeySelection::SelectedKey> keys = selection.get_sorted();
+	float motion = moving_selection_offset;
 
-		undo_redo->add_do_method(this, "_select_at_anim", animation, E->key().track, newpos);
-		undo_redo->add_undo_method(this, "_select_at_anim", animation, E->key().track, oldpos);
+	Vector<float> new_times;
+	PoolIntArray tracks;
+	PoolRealArray old_times;
+	PoolRealArray moved_times;
+	new_times.resize(keys.size());
+	for (int i = 0; i < keys.size(); i++) {
+		new_times.write[i] = snap_time(keys[i].pos + motion);
+		tracks.push_back(keys[i].track);
+		old_times.push_back(keys[i].pos);
+		moved_times.push_back(new_times[i]);
 	}
 
+	undo_redo->create_action(TTR("Anim Move Keys"));
+	_add_key_blocks_undo(keys, new_times);
+	undo_redo->add_do_method(this, "_select_keys_at_anim", animation, tracks, moved_times);
+	undo_redo->add_undo_method(this, "_select_keys_at_anim", animation, tracks, old_times);
 	undo_redo->commit_action();
 
+	_mark_selected_tracks_dirty();
+	_queue_dirty_tracks_flush();
 	moving_selection = false;
-	for (int i = 0; i < track_edits.size(); i++) {
-		track_edits[i]->update();
-	}
-	for (int i = 0; i < track_edit_headers.size(); i++) {
-		track_edit_headers[i]->update();
-	}
 
 	_update_key_edit();
 }
 
 void TrackEditor::_move_selection_cancel() {
+	_mark_selected_tracks_dirty();
+	_queue_dirty_tracks_flush();
 	moving_selection = false;
-	for (int i = 0; i < track_edits.size(); i++) {
-		track_edits[i]->update();
-	}
-	for (int i = 0; i < track_edit_headers.size(); i++) {
-		track_edit_headers[i]->update();
-	}
 }
 
 bool TrackEditor::is_moving_selection() const {
@@ -1810,14 +2477,19 @@ void TrackEditor::_scroll_input(const Ref<InputEvent>& p_event) {
 		else if (box_selecting) {
 			if (box_selection->is_visible_in_tree()) {
 				// Only if moved.
+				TrackEdit* last_track_edit = nullptr;
 				for (int i = 0; i < track_edits.size(); i++) {
+					if (!track_edits[i]) {
+						continue; // Not instantiated, so not under the box either.
+					}
 					Rect2 local_rect = box_select_rect;
 					local_rect.position -= track_edits[i]->get_global_position();
 					track_edits[i]->append_to_selection(local_rect, mb->get_command());
+					last_track_edit = track_edits[i];
 				}
 
-				if (_get_track_selected() == -1 && track_edits.size() > 0) { // Minimal hack to make shortcuts work.
-					track_edits[track_edits.size() - 1]->grab_focus();
+				if (_get_track_selected() == -1 && last_track_edit) { // Minimal hack to make shortcuts work.
+					last_track_edit->grab_focus();
 				}
 			}
 			else {
@@ -1901,11 +2573,11 @@ void TrackEditor::_zoom_callback(Vector2 p_scroll_vec, Vector2 p_origin, bool p_
 void TrackEditor::_anim_duplicate_keys(bool transpose) {
 	// Duplicait!
 	if (selection.size() && animation.is_valid() && (!transpose || (_get_track_selected() >= 0 && _get_track_selected() < animation->get_track_count()))) {
+		const Vector<KeySelection::SelectedKey> keys = selection.get_sorted();
 		int top_track = 0x7FFFFFFF;
 		float top_time = 1e10;
-		for (Map<SelectedKey, KeyInfo>::Element* E = selection.back(); E; E = E->prev()) {
-			const SelectedKey& sk = E->key();
-
+		for (int i = keys.size() - 1; i >= 0; i--) {
+			const KeySelection::SelectedKey& sk = keys[i];
 			float t = animation->track_get_key_time(sk.track, sk.key);
 			if (t < top_time) {
 				top_time = t;
@@ -1924,9 +2596,8 @@ void TrackEditor::_anim_duplicate_keys(bool transpose) {
 
 		List<Pair<int, float>> new_selection_values;
 
-		for (Map<SelectedKey, KeyInfo>::Element* E = selection.back(); E; E = E->prev()) {
-			const SelectedKey& sk = E->key();
-
+		for (int i = keys.size() - 1; i >= 0; i--) {
+			const KeySelection::SelectedKey& sk = keys[i];
 			float t = animation->track_get_key_time(sk.track, sk.key);
 
 			float dst_time = t + (timeline->get_play_position() - top_time);
@@ -1942,7 +2613,7 @@ void TrackEditor::_anim_duplicate_keys(bool transpose) {
 
 			int existing_idx = animation->track_find_key(dst_track, dst_time, true);
 
-			undo_redo->add_do_method(animation.ptr(), "track_insert_key", dst_track, dst_time, animation->track_get_key_value(E->key().track, E->key().key), animation->track_get_key_transition(E->key().track, E->key().key));
+			undo_redo->add_do_method(animation.ptr(), "track_insert_key", dst_track, dst_time, animation->track_get_key_value(sk.track, sk.key), animation->track_get_key_transition(sk.track, sk.key));
 			undo_redo->add_undo_method(animation.ptr(), "track_remove_key_at_time", dst_track, dst_time);
 
 			Pair<int, float> p;
@@ -1959,7 +2630,7 @@ void TrackEditor::_anim_duplicate_keys(bool transpose) {
 
 		// Reselect duplicated.
 
-		Map<SelectedKey, KeyInfo> new_selection;
+		selection.clear();
 		for (List<Pair<int, float>>::Element* E = new_selection_values.front(); E; E = E->next()) {
 			int track = E->get().first;
 			float time = E->get().second;
@@ -1969,17 +2640,10 @@ void TrackEditor::_anim_duplicate_keys(bool transpose) {
 			if (existing_idx == -1) {
 				continue;
 			}
-			SelectedKey sk2;
-			sk2.track = track;
-			sk2.key = existing_idx;
 
-			KeyInfo ki;
-			ki.pos = time;
-
-			new_selection[sk2] = ki;
+			selection.insert(track, existing_idx, time);
 		}
 
-		selection = new_selection;
 		_update_tracks();
 		_update_key_edit();
 	}
@@ -2193,13 +2857,15 @@ void TrackEditor::_edit_menu_pressed(int p_option) {
 			return;
 		}
 
+		const Vector<KeySelection::SelectedKey> keys = selection.get_sorted();
 		float from_t = 1e20;
 		float to_t = -1e20;
 		float len = -1e20;
 		float pivot = 0;
 
-		for (Map<SelectedKey, KeyInfo>::Element* E = selection.front(); E; E = E->next()) {
-			float t = animation->track_get_key_time(E->key().track, E->key().key);
+		for (int i = 0; i < keys.size(); i++) {
+			const KeySelection::SelectedKey& sk = keys[i];
+			float t = animation->track_get_key_time(sk.track, sk.key);
 			if (t < from_t) {
 				from_t = t;
 			}
@@ -2222,75 +2888,28 @@ void TrackEditor::_edit_menu_pressed(int p_option) {
 			ERR_PRINT("Can't scale to 0");
 		}
 
-		undo_redo->create_action(TTR("Anim Scale Keys"));
-
-		List<_AnimMoveRestore> to_restore;
-
-		// 1 - Remove the keys.
-		for (Map<SelectedKey, KeyInfo>::Element* E = selection.back(); E; E = E->prev()) {
-			undo_redo->add_do_method(animation.ptr(), "track_remove_key", E->key().track, E->key().key);
-		}
-		// 2 - Remove overlapped keys.
-		for (Map<SelectedKey, KeyInfo>::Element* E = selection.back(); E; E = E->prev()) {
-			float newtime = (E->get().pos - from_t) * s + from_t;
-			int idx = animation->track_find_key(E->key().track, newtime, true);
-			if (idx == -1) {
-				continue;
-			}
-			SelectedKey sk;
-			sk.key = idx;
-			sk.track = E->key().track;
-			if (selection.has(sk)) {
-				continue; // Already in selection, don't save.
-			}
-
-			undo_redo->add_do_method(animation.ptr(), "track_remove_key_at_time", E->key().track, newtime);
-			_AnimMoveRestore amr;
-
-			amr.key = animation->track_get_key_value(E->key().track, idx);
-			amr.track = E->key().track;
-			amr.time = newtime;
-			amr.transition = animation->track_get_key_transition(E->key().track, idx);
-
-			to_restore.push_back(amr);
-		}
-
 #define NEW_POS(m_ofs) (((s > 0) ? m_ofs : from_t + (len - (m_ofs - from_t))) - pivot) * ABS(s) + from_t
-		// 3 - Move the keys (re insert them).
-		for (Map<SelectedKey, KeyInfo>::Element* E = selection.back(); E; E = E->prev()) {
-			float newpos = NEW_POS(E->get().pos);
-			undo_redo->add_do_method(animation.ptr(), "track_insert_key", E->key().track, newpos, animation->track_get_key_value(E->key().track, E->key().key), animation->track_get_key_transition(E->key().track, E->key().key));
-		}
-
-		// 4 - (Undo) Remove inserted keys.
-		for (Map<SelectedKey, KeyInfo>::Element* E = selection.back(); E; E = E->prev()) {
-			float newpos = NEW_POS(E->get().pos);
-			undo_redo->add_undo_method(animation.ptr(), "track_remove_key_at_time", E->key().track, newpos);
-		}
-
-		// 5 - (Undo) Reinsert keys.
-		for (Map<SelectedKey, KeyInfo>::Element* E = selection.back(); E; E = E->prev()) {
-			undo_redo->add_undo_method(animation.ptr(), "track_insert_key", E->key().track, E->get().pos, animation->track_get_key_value(E->key().track, E->key().key), animation->track_get_key_transition(E->key().track, E->key().key));
-		}
-
-		// 6 - (Undo) Reinsert overlapped keys.
-		for (List<_AnimMoveRestore>::Element* amr = to_restore.front(); amr; amr = amr->next()) {
-			undo_redo->add_undo_method(animation.ptr(), "track_insert_key", amr->get().track, amr->get().time, amr->get().key, amr->get().transition);
-		}
-
-		undo_redo->add_do_method(this, "_clear_selection_for_anim", animation);
-		undo_redo->add_undo_method(this, "_clear_selection_for_anim", animation);
-
-		// 7-reselect.
-		for (Map<SelectedKey, KeyInfo>::Element* E = selection.back(); E; E = E->prev()) {
-			float oldpos = E->get().pos;
-			float newpos = NEW_POS(oldpos);
-			if (newpos >= 0) {
-				undo_redo->add_do_method(this, "_select_at_anim", animation, E->key().track, newpos);
+		Vector<float> new_times;
+		PoolIntArray new_tracks;
+		PoolRealArray scaled_times;
+		PoolIntArray old_tracks;
+		PoolRealArray old_times;
+		new_times.resize(keys.size());
+		for (int i = 0; i < keys.size(); i++) {
+			new_times.write[i] = NEW_POS(keys[i].pos);
+			if (new_times[i] >= 0) {
+				new_tracks.push_back(keys[i].track);
+				scaled_times.push_back(new_times[i]);
 			}
-			undo_redo->add_undo_method(this, "_select_at_anim", animation, E->key().track, oldpos);
+			old_tracks.push_back(keys[i].track);
+			old_times.push_back(keys[i].pos);
 		}
 #undef NEW_POS
+
+		undo_redo->create_action(TTR("Anim Scale Keys"));
+		_add_key_blocks_undo(keys, new_times);
+		undo_redo->add_do_method(this, "_select_keys_at_anim", animation, new_tracks, scaled_times);
+		undo_redo->add_undo_method(this, "_select_keys_at_anim", animation, old_tracks, old_times);
 		undo_redo->commit_action();
 	} break;
 	case EDIT_DUPLICATE_SELECTION: {
@@ -2305,9 +2924,9 @@ void TrackEditor::_edit_menu_pressed(int p_option) {
 		int reset_tracks = reset->get_track_count();
 		Set<int> tracks_added;
 
-		for (Map<SelectedKey, KeyInfo>::Element* E = selection.front(); E; E = E->next()) {
-			const SelectedKey& sk = E->key();
-
+		const Vector<KeySelection::SelectedKey> keys = selection.get_sorted();
+		for (int k = 0; k < keys.size(); k++) {
+			const KeySelection::SelectedKey& sk = keys[k];
 			// Only add one key per track.
 			if (tracks_added.has(sk.track)) {
 				continue;
@@ -2353,10 +2972,7 @@ void TrackEditor::_edit_menu_pressed(int p_option) {
 		if (selection.size()) {
 			undo_redo->create_action(TTR("Anim Delete Keys"));
 
-			for (Map<SelectedKey, KeyInfo>::Element* E = selection.back(); E; E = E->prev()) {
-				undo_redo->add_do_method(animation.ptr(), "track_remove_key", E->key().track, E->key().key);
-				undo_redo->add_undo_method(animation.ptr(), "track_insert_key", E->key().track, E->get().pos, animation->track_get_key_value(E->key().track, E->key().key), animation->track_get_key_transition(E->key().track, E->key().key));
-			}
+			_add_key_blocks_undo(selection.get_sorted(), Vector<float>());
 			undo_redo->add_do_method(this, "_clear_selection_for_anim", animation);
 			undo_redo->add_undo_method(this, "_clear_selection_for_anim", animation);
 			undo_redo->commit_action();
@@ -2484,12 +3100,7 @@ void TrackEditor::_selection_changed() {
 		_update_tracks(); // Needs updatin.
 	}
 	else {
-		for (int i = 0; i < track_edits.size(); i++) {
-			track_edits[i]->update();
-		}
-		for (int i = 0; i < track_edit_headers.size(); i++) {
-			track_edit_headers[i]->update();
-		}
+		_update_track_edits();
 
 	}
 }
@@ -2568,16 +3179,26 @@ void TrackEditor::_bind_methods() {
 	ClassDB::bind_method("is_selection_active", &TrackEditor::is_selection_active);
 	ClassDB::bind_method("get_control", &TrackEditor::get_control);
 	ClassDB::bind_method(D_METHOD("is_key_selected", "track", "key"), &TrackEditor::is_key_selected);
+	ClassDB::bind_method(D_METHOD("has_selected_keys", "track"), &TrackEditor::has_selected_keys);
 	ClassDB::bind_method("is_moving_selection", &TrackEditor::is_moving_selection);
 	ClassDB::bind_method("get_moving_selection_offset", &TrackEditor::get_moving_selection_offset);
 	ClassDB::bind_method(D_METHOD("set_anim_pos", "pos"), &TrackEditor::set_anim_pos);
 	ClassDB::bind_method(D_METHOD("set_control", "control"), &TrackEditor::set_control);
 
 	ClassDB::bind_method("_animation_update", &TrackEditor::_animation_update);
+	ClassDB::bind_method("_flush_dirty_tracks", &TrackEditor::_flush_dirty_tracks);
 	ClassDB::bind_method("_track_grab_focus", &TrackEditor::_track_grab_focus);
 	ClassDB::bind_method("_update_tracks", &TrackEditor::_update_tracks);
+	ClassDB::bind_method("_update_visible_rows", &TrackEditor::_update_visible_rows);
+	ClassDB::bind_method("_queue_visible_rows_update", &TrackEditor::_queue_visible_rows_update);
+	ClassDB::bind_method(D_METHOD("_track_rows_scrolled"), &TrackEditor::_track_rows_scrolled);
+	ClassDB::bind_method(D_METHOD("get_track_edit_for", "track"), &TrackEditor::get_track_edit_for);
+	ClassDB::bind_method(D_METHOD("set_virtualize_tracks", "enable"), &TrackEditor::set_virtualize_tracks);
+	ClassDB::bind_method("is_virtualizing_tracks", &TrackEditor::is_virtualizing_tracks);
 	ClassDB::bind_method("_clear_selection_for_anim", &TrackEditor::_clear_selection_for_anim);
 	ClassDB::bind_method("_select_at_anim", &TrackEditor::_select_at_anim);
+	ClassDB::bind_method("_select_keys_at_anim", &TrackEditor::_select_keys_at_anim);
+	ClassDB::bind_method("_apply_track_keys", &TrackEditor::_apply_track_keys);
 
 	ClassDB::bind_method("_key_selected", &TrackEditor::_key_selected); // Still used by some connect_compat.
 	ClassDB::bind_method("_key_deselected", &TrackEditor::_key_deselected); // Still used by some connect_compat.
@@ -2623,6 +3244,7 @@ void TrackEditor::_bind_methods() {
 	ADD_SIGNAL(MethodInfo("animation_step_changed", PropertyInfo(Variant::REAL, "step")));
 
 	ADD_PROPERTY(PropertyInfo(Variant::REAL, "step"), "set_step", "get_step");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "virtualize_tracks"), "set_virtualize_tracks", "is_virtualizing_tracks");
 }
 
 void TrackEditor::_icons_cache_changed() {
@@ -2748,6 +3370,8 @@ TrackEditor::TrackEditor() {
 	timeline_scroll->add_child(sb); // Move here so timeline and tracks are always aligned.
 	scroll->set_focus_mode(FOCUS_CLICK);
 	scroll->connect("gui_input", this, "_scroll_input");
+	scroll->connect("resized", this, "_queue_visible_rows_update");
+	sb->connect("value_changed", this, "_track_rows_scrolled");
 	scroll->connect("focus_exited", panner.ptr(), "release_pan_key");
 
 	timeline_vbox->set_custom_minimum_size(Size2(0, 150) * 1.0);
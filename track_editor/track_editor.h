@@ -13,6 +13,8 @@
 #include "scene/gui/texture_rect.h"
 #include "scene/resources/animation.h"
 
+#include "key_selection.h"
+
 class PlayerEditorControl;
 class UndoRedo;
 class TreeItem;
@@ -54,6 +56,46 @@ class TrackEditor : public VBoxContainer {
 
 	Vector<TrackEdit*> track_edit_headers;
 	Vector<TrackEdit*> track_edits;
+	// What each entry of track_edits was built for, edits are reused for tracks with the same key.
+	Vector<String> track_edit_keys;
+
+	// With virtualize_tracks only the rows in the scroll viewport have a TrackEdit, track_edits is null for the rest.
+	enum {
+		VISIBLE_ROWS_MARGIN = 4
+	};
+
+	struct TrackRow {
+		int track = -1; // -1 for group headers.
+		TrackEdit* header = nullptr;
+		Ref<Script> script;
+		String key;
+		NodePath path;
+		Animation::TrackType type = Animation::TYPE_VALUE;
+		TrackEdit* track_edit = nullptr;
+		bool plain = false; // No plugin claims the track, any pooled TrackEdit can show it.
+		float height = 0;
+	};
+
+	// Only the rows in view get a TrackEdit, and rows scrolled away give theirs back to the pool.
+	// get_track_edit_for then returns null for tracks out of view, and the edit a track had may be
+	// showing another track by the time it scrolls back, so callers look it up again each time.
+	bool virtualize_tracks = false;
+	Vector<TrackRow> track_rows;
+	Vector<TrackEdit*> track_edit_pool;
+	Control* rows_top_spacer = nullptr;
+	Control* rows_bottom_spacer = nullptr;
+	float default_row_height = 0;
+	bool visible_rows_update_queued = false;
+
+	void _update_track_rows();
+	void _bind_track_row(int p_row, Map<String, List<TrackEdit*>>* r_reusable);
+	void _release_track_row(int p_row);
+	void _recycle_track_edit(TrackEdit* p_track_edit);
+	void _bind_visible_rows(Map<String, List<TrackEdit*>>* r_reusable);
+	void _update_visible_rows();
+	void _queue_visible_rows_update();
+	void _track_rows_scrolled(double);
+	static bool _is_plain_track_edit(TrackEdit* p_track_edit);
 
 	Button* imported_anim_warning = nullptr;
 	void _show_imported_anim_warning();
@@ -65,6 +107,29 @@ class TrackEditor : public VBoxContainer {
 	int _get_track_selected();
 	void _animation_changed();
 	void _update_tracks();
+	void _rebuild_tracks();
+	void _clear_track_edits();
+	String _get_track_edit_key(int p_track, const Ref<Script>& p_script) const;
+	TrackEdit* _take_reusable_track_edit(Map<String, List<TrackEdit*>>& r_reusable, const String& p_key, int p_track);
+	TrackEdit* _create_track_edit(int p_track);
+	TrackEdit* _create_plugin_track_edit(int p_track);
+	void _update_track_edits();
+
+	// Tracks waiting for a redraw, with the key time range that changed in each one (x to y).
+	// Everything is flushed once per frame, and only rows whose range reaches the visible timeline redraw.
+	Map<int, Vector2> dirty_tracks;
+	bool all_tracks_dirty = false;
+	bool dirty_tracks_flush_queued = false;
+	// Track whose keys are being replaced by _apply_track_keys, its changed notification only dirties that track.
+	int applying_keys_track = -1;
+	bool animation_change_unknown = false;
+
+	void _mark_track_dirty(int p_track);
+	void _mark_track_dirty(int p_track, float p_from, float p_to);
+	void _mark_selection_dirty();
+	void _mark_selected_tracks_dirty();
+	void _queue_dirty_tracks_flush();
+	void _flush_dirty_tracks();
 
 	void _name_limit_changed();
 	void _timeline_changed(float p_new_pos, bool p_drag, bool p_timeline_only);
@@ -141,20 +206,16 @@ class TrackEditor : public VBoxContainer {
 	void _clear_selection(bool p_update = false);
 	void _clear_selection_for_anim(const Ref<Animation>& p_anim);
 	void _select_at_anim(const Ref<Animation>& p_anim, int p_track, float p_pos);
+	void _select_keys_at_anim(const Ref<Animation>& p_anim, const PoolIntArray& p_tracks, const PoolRealArray& p_times);
 
-	//selection
-
-	struct SelectedKey {
-		int track = 0;
-		int key = 0;
-		bool operator<(const SelectedKey& p_key) const { return track == p_key.track ? key < p_key.key : track < p_key.track; };
-	};
+	// Undo for key edits snapshots each affected track as one block of typed arrays.
+	Dictionary _get_track_keys(int p_track) const;
+	void _apply_track_keys(const Ref<Animation>& p_anim, int p_track, const Dictionary& p_keys);
+	void _add_key_blocks_undo(const Vector<KeySelection::SelectedKey>& p_keys, const Vector<float>& p_new_times);
 
-	struct KeyInfo {
-		float pos = 0;
-	};
+	//selection
 
-	Map<SelectedKey, KeyInfo> selection;
+	KeySelection selection;
 
 	void _key_selected(int p_key, bool p_single, int p_track);
 	void _key_deselected(int p_key, int p_track);
@@ -243,6 +304,7 @@ class TrackEditor : public VBoxContainer {
 	void _icons_cache_changed();
 
 	void add_track_edit(TrackEdit *p_track_edit, int p_track, bool p_is_header);
+	void _connect_track_index_signals(TrackEdit* p_track_edit, int p_track);
 
 	const StringName _get_index_of_track_edit_belonging_to_header = "get_index_of_track_edit_belonging_to_header";
 
@@ -291,7 +353,11 @@ public:
 
 	void cleanup();
 
+	// The edit drawing p_track right now, or null. Without virtualize_tracks that is only for invalid tracks,
+	// with it also for every track scrolled out of view. Don't keep the result, see virtualize_tracks.
 	TrackEdit* get_track_edit_for(int p_track) const;
+	void set_virtualize_tracks(bool p_enable);
+	bool is_virtualizing_tracks() const;
 
 	void set_anim_pos(float p_pos);
 	void insert_node_value_key(Node* p_node, const String& p_property, const Variant& p_value, bool p_only_if_exists = false);
@@ -306,6 +372,7 @@ public:
 	void set_remove_on_remove_request(bool p_remove_enabled);
 
 	bool is_key_selected(int p_track, int p_key) const;
+	bool has_selected_keys(int p_track) const;
 	bool is_selection_active() const;
 	bool is_moving_selection() const;
 	bool is_snap_enabled() const;